@@ -9,11 +9,16 @@
  *  advanced pruning functions are left to the game module since they make use
  *  of the requirements struct.
  * 
- *  Trie insert/search are both in constant time but with pretty enormous constants
- *  compared to things like hash tables since a dyanmic trie means you could have
- *  to navigate up to 64 nodes to find a letter. A static, array-based approach
- *  will not work due to size constraints, even if resizing arrays. This solution
- *  barely makes the space constraints.
+ *  Trie insert/search are both in constant time. A static, array-based approach
+ *  (64 pointers per node) will not work due to size constraints, so each branch
+ *  instead keeps a 64-bit map of the letters it has children for, and a dense
+ *  array holding only those children: the child for a letter is found with a
+ *  popcount of the map bits below it, without walking any list. Nodes are the
+ *  same 24B as a linked sibling list, so this still makes the space constraints.
+ *  Chains of nodes with a single child are merged into one node whose edge is
+ *  labeled with all of their letters (radix trie), so a node is only created
+ *  where words actually branch. Every branch also knows which letters appear
+ *  beneath it, so pruning can drop subtrees that lack a letter the bounds need.
  * 
  *  The project specifies that all strings be the same size, so this trie does
  *  not support insertion of strings of different lengths.
@@ -24,22 +29,36 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include "arena.h"
 
 #define CHARSET 64
 #define PRUNE 3
 #define TEMP_PRUNE 2
 #define NO_PRUNE 1
+#define EPOCHS 64       // games between two full resets of the prune values
+
+#define BIT(i) ((uint64_t)1 << (i))
+#define N_CHILDREN(trie) ((uint8_t) __builtin_popcountll((trie)->map))
+
+/**
+ * @brief Convert characters to 0-63 interval, defined in trie.c
+ *
+ *         index = conversion_table[(int) letter]
+ */
+extern const uint8_t conversion_table[128];
 
 
 /** @brief Dynamic trie with status array containing string and pruning info
  * 
- *      TRIE (dynamic, partially compressed at the leaves):
+ *      TRIE (dynamic, path compressed):
  *
- *  * STATUS:  1B = prune | (1+)B = suffix
+ *  * STATUS:  1B = prune | (1+)B = label | 8B = subtree mask (branches only)
  *  |
  *  | - to save space, the trie is compressed at the leaves. instead of building
  *  |   a chain of nodes linking to a single nodes the rest of the word is saved
  *  |   in the suffix
+ *  | - chains of branches with a single child are compressed the same way, the
+ *  |   letters of the whole chain are the label of a single branch
  *  | - for optimal packing, the prune byte is saved within the suffix at the
  *  |   first address. this is because keeping it within the struct would push
  *  |   its size to 25B which would then be rounded to 32B, completely wasting
@@ -53,54 +72,129 @@
  *      checked in the future.
  *    - for debugging purposes it uses the values PRUNE/TEMP_PRUNE/NO_PRUNE, the
  *      special TEMP_PRUNE value is used to prune branches with no valid leaves
- *      under them. Since these are not properly pruned, this must be reset at
- *      every insertion, and is handled by prune_trie
+ *      under them. Since these are not properly pruned, inserting a valid word
+ *      resets them (and every other node on its path) to NO_PRUNE. A branch
+ *      whose subtree mask lacks a needed letter is also TEMP_PRUNE, without
+ *      its children being visited, so the reset marks them TEMP_PRUNE first
+ *    - the prune char holds the value in the low 2 bits and the game (epoch)
+ *      it was set in above them. A value from an older epoch reads as NO_PRUNE,
+ *      so starting a game just moves to the next epoch, and the whole trie is
+ *      only reset when the epochs run out. A plain NO_PRUNE (epoch 0) is valid
+ *      in every game, which is what new nodes get
  * 
  *
  *  * NODES:
  * 
- *    - each node always has at least 2 chars in status. use:
- *      (node->status)[1] ---> letter that represents the node
- *    - eache level of the trie is a linked list of nodes, accessible through the
- *      next field
- *    - to travel down the trie, use the branch field.
+ *    - each node but the root has at least 3 chars in status. use:
+ *      (node->status)[1] ---> first letter of the label of the node
+ *    - the children of a branch are stored next to each other in the branch
+ *      array, ordered like the letters so iterating it is a lexicographical
+ *      visit of the level. There are N_CHILDREN(node) of them
+ *    - bit i of map is set if the node has a child for the letter with index i
+ *      in conversion_table, and that child is at branch[popcount(map & (2^i - 1))]
+ *    - the root is a branch without a letter, it's never pruned and its status
+ *      is only used to keep every node uniform
  *
  *      + LEAVES:
- *   1) trie->branch == NULL
+ *   1) trie->branch == NULL, trie->map == 0
  *   2) trie->status contains the prune char and a suffix string of len >=1 with
  *      a terminating null character
  * 
  *      + BRANCHES:
  *   1) trie->branch != NULL
- *   2) trie->status DOES NOT have any terminating null character, and consists
- *      of only two chars, one for prune bit and the other for the "index" of
- *      the node to navigate the trie.
+ *   2) trie->status contains the prune char and a label of len >= 1 with a
+ *      terminating null character. The label holds the letters between the
+ *      parent and the next place where the words below branch out, so a branch
+ *      other than the root always has at least 2 children
+ *   3) right after the null character, an unaligned 64-bit mask with bit i set
+ *      if the letter with index i appears in any label beneath the branch (not
+ *      in its own). It only ever grows, words are never removed
  */
 typedef struct trie {
-    struct trie *next;
+    uint64_t map;
     struct trie *branch;
     char *status;
 } trie_t;
 
+extern uint8_t prune_epoch;     // epoch of the current game, 1 to EPOCHS - 1
+
+#define STAMP(p) ((char)((prune_epoch << 2) | (p)))
+#define GET_PRUNE(trie) \
+    ((((uint8_t)((trie)->status)[0] >> 2) == prune_epoch) ? (((trie)->status)[0] & 3) : NO_PRUNE)
+#define SET_PRUNE(trie, p) (((trie)->status)[0] = STAMP(p))
+
+#define BRANCH_SIZE(len) (((len) + 2)*sizeof(char) + sizeof(uint64_t))   // status size of a branch
+
+/**
+ * @brief Letters appearing beneath a branch
+ * @param trie      branch node
+ * @param len       length of its label
+ * @return uint64_t subtree mask of the branch
+ */
+static inline uint64_t subtree_mask(const trie_t *trie, uint8_t len){
+    uint64_t mask;
+
+    memcpy(&mask, trie->status + (len + 2)*sizeof(char), sizeof(mask));
+    return mask;
+}
+
 /**
  * @brief Inserts string into trie and returns updated trie     O(k)
  * 
  *  To initialize the tree pass a NULL node as the root. All inserted words must
  *  be unique, this is a requirement for the project input.
  * 
+ *  The leaf of the word gets the prune value p. If the word is NO_PRUNE, every
+ *  node on its path is also set to NO_PRUNE, so that a word inserted during a
+ *  game doesn't require pruning the trie again.
+ * 
  * @param root      root of the trie to insert the string in
- * @param word      word to save on the trie
+ * @param word      word to save on the trie, doesn't need to be terminated
+ * @param len       length of the word
+ * @param p         prune value of the word (PRUNE or NO_PRUNE)
  * @return trie_t*  returns the new root
  */
-trie_t *insert(trie_t *, char *);
+trie_t *insert(trie_t *, const char *, uint8_t, char);
+
+/**
+ * @brief Builds a trie from a sorted array of words             O(nk)
+ *
+ *  Bulk alternative to inserting the words one at a time: every node is
+ *  created once, with its final child array, in depth first order. The words
+ *  must be unique, and are all NO_PRUNE. A trie built in another arena is
+ *  only a part of the dictionary, and must be joined with join_tries().
+ *
+ * @param mem       arena to allocate the nodes from, NULL for the dictionary's
+ * @param rows      words, each one in a row of len + 1 chars
+ * @param sorted    handles (row indices) of the words in lexicographical order
+ * @param n         number of words
+ * @param len       length of the words
+ * @return trie_t*  root of the new trie
+ */
+trie_t *build_trie(arena_t *, const char *, const uint32_t *, uint32_t, uint8_t);
+
+/**
+ * @brief Joins tries built in separate arenas under a single root   O(parts)
+ *
+ *  Meant for parts built by different threads, each one with the words that
+ *  start with some of the letters. The arenas are moved into the dictionary's.
+ *
+ * @param parts     roots of the parts, with disjoint and increasing letters
+ * @param n         number of parts
+ * @param mems      arenas the parts were built in, left empty
+ * @param n_mems    number of arenas
+ * @return trie_t*  root of the joined trie
+ */
+trie_t *join_tries(trie_t **, uint8_t, arena_t *, uint8_t);
 
 /**
  * @brief Searches trie for target string                       O(k)
  * @param root      root of the trie to search the string in
- * @param word      word to search in the trie
+ * @param word      word to search in the trie, doesn't need to be terminated
+ * @param len       length of the word
  * @return int      1 = found  0 = not found
  */
-int search(trie_t *, char *);
+int search(trie_t *, const char *, uint8_t);
 
 /**
  * @brief Prints the trie lexicographically in column           O(n)
@@ -110,9 +204,18 @@ int search(trie_t *, char *);
 void print_trie(trie_t *, uint8_t);
 
 /**
- * @brief Resets prune values in the trie to NO_PRUNE           O(n)
+ * @brief Resets prune values in the trie to NO_PRUNE           O(1)
+ *
+ *  Amortized, the whole trie is walked once every EPOCHS - 1 calls.
+ *
  * @param trie      root of the trie to reset
  */
 void clear_trie(trie_t *);
 
+/**
+ * @brief Frees every node of the dictionary                    O(1)
+ * @param trie      root of the trie to free
+ */
+void free_trie(trie_t *);
+
 #endif
\ No newline at end of file
@@ -14,11 +14,17 @@
  *  we get the same result as merging the requirements of guess_1 and guess_2
  *  and filtering based on those (much more expensive). Insertion breaks this
  *  "transitivity" property of the filtering.
+ *
+ *  Since the survivors already pass guess_1, filtering them for guess_2 only
+ *  needs what guess_2 added: each evaluation leaves it in a second req_t, the
+ *  delta, which the engines filter with just like with the full requirements.
  */
 #ifndef GAME_H_
 #define GAME_H_
 
 #include "trie.h"
+#include "list.h"
+#include "hset.h"
 
 /** @brief Struct to save constraints imposed by guesses throughout each game
  * 
@@ -26,48 +32,109 @@
  *
  *  - ref:              reference string for the current game
  * 
- *  - match[i] = '*'    if the exact value of the i-th position hasn't been found
- *    match[i] = char   if char has been discovered
+ *  - code[i]:          index of the i-th letter of ref in conversion_table
+ * 
+ *  - hist[i]:          occurrences of the i-th char in ref
+ * 
+ *  - delta:            constraints added by the last guess, as a req_t whose
+ *                      positions allow every letter unless their mask changed,
+ *                      and whose known/exact only hold the letters whose bound
+ *                      changed (count is a copy). NULL in the delta itself
+ * 
+ *  - pos[i]:           bitmask of the letters that can still occupy the i-th
+ *                      position, indexed through conversion_table. A match
+ *                      leaves a single bit set, and a letter known not to
+ *                      appear is cleared from every position
  * 
- *  - occs[i]:
- *         -1     --->    number of occurrences of i-th char is not bound
- *          0     --->    i-th char does not appear
- *        x < -1  --->    i-th char appears at least (-x - 1) times, 
- *                        e.g. if -3 at least twice
- *        x > 0   --->    i-th char appears exactly x times.
+ *  - known:            bitmask of the letters with an occurrence bound of at
+ *                      least one
+ * 
+ *  - exact:            bitmask of the letters whose bound is exact
+ * 
+ *  - count[i]:         minimum (or exact, if set in the exact mask) number of
+ *                      occurrences of the i-th char
  *        
  *   occurrences must be counted as total occurrences. this is because the
  *   following situation can't be solved efficiently when counting "free" occs
  *   (which means excluding matching letters from the count)
  *  
  *     ref = "abc"
- *     s1  = "add" --> eval = "+//"   occs["a"] = -1
- *     s2  = "dad" --> eval = "|//"   occs["a"] = -2
+ *     s1  = "add" --> eval = "+//"   count["a"] >= 1
+ *     s2  = "dad" --> eval = "|//"   count["a"] >= 1
  * 
- *    now we would have to check the whole (reqs->match) string to see that 'a'
- *    appears once in there and hence we don't actually have a "free" occurrence
- *    of 'a'. this would be far too inefficient
- *
- *  - pos[char][i] = 1  char can occupy i-th position
- *    pos[char][i] = 0  char cannot occupy i-th position
+ *    now we would have to check every position with a single bit in pos to see
+ *    that 'a' appears once in there and hence we don't actually have a "free"
+ *    occurrence of 'a'. this would be far too inefficient
+ * 
+ *  A word is then checked by testing each of its letters against pos and by
+ *  comparing its letter histogram against count for the letters in known.
+ *  The whole struct is a single allocation, with ref and code stored right
+ *  after pos. code and hist never change during a game, they're there so that
+ *  evaluating a guess doesn't have to go through ref letter by letter again.
  */
 typedef struct reqs {
     char *ref;
-    char *match;
-    int8_t occs[CHARSET];
-    uint8_t *pos[CHARSET];
+    uint8_t *code;
+    uint8_t hist[CHARSET];
+    struct reqs *delta;
+    uint64_t known;
+    uint64_t exact;
+    uint8_t count[CHARSET];
+    uint64_t pos[];
 } req_t;
 
 
-// needed for errorless compilation, used only for wordsize outside
-void safe_scanf(uint8_t *);
+#define ENGINE_TRIE 0   // survivors are the non pruned leaves of the trie
+#define ENGINE_LIST 1   // survivors are kept in a separate array (list.h)
+#define ENGINE_COLS 2   // survivors are a bitset over a columnar store (cols.h)
+#define ENGINE_LOUDS 3  // survivors are the non pruned leaves of a succinct trie (louds.h)
+
+#define NEW_GAME     "+nuova_partita"
+#define INSERT_START "+inserisci_inizio"
+#define PRINT        "+stampa_filtrate"
+#define SUGGEST      "+suggerisci"
+#define IS_CMD(line, len, cmd) ((len) == sizeof(cmd) - 1 && memcmp((line), (cmd), (len)) == 0)
+
+/**
+ * @brief Opens stdin/stdout, must be called before anything else is read
+ */
+void open_streams(void);
+
+/**
+ * @brief Reads the size of the words from the first line
+ * @return uint8_t  size of the words
+ */
+uint8_t read_wordsize(void);
+
+/**
+ * @brief Selects the filtering engine, must be called before initial_read
+ * @param engine    ENGINE_TRIE, ENGINE_LIST, ENGINE_COLS or ENGINE_LOUDS
+ */
+void set_engine(uint8_t);
+
+/**
+ * @brief Uses a dictionary that was already loaded, must be called before initial_read
+ * 
+ *  The dictionary comes in the list/hash set layout, so ENGINE_TRIE is replaced
+ *  by ENGINE_LIST.
+ * 
+ * @param words     word store, with no pending words
+ * @param set       hash set of the same words
+ */
+void set_dictionary(list_t *, hset_t *);
+
+/**
+ * @brief Sets the number of threads used to prune the trie
+ * @param n         number of threads, 1 keeps pruning serial
+ */
+void set_threads(uint8_t);
 
 /**
  * @brief Reads initial dictionary and returns filled trie
  * 
  *  Reads the entire initial dictionary until +nuova_partita, or in case of
  *  +inserisci_inizio also handles that. Returns control flow after having fully
- *  read +nuova_partita from buffer
+ *  read +nuova_partita from the input
  *
  * @param trie      init to NULL (lazy ik)
  * @param wordsize  size of the words in input(read previously)
@@ -75,6 +142,67 @@ void safe_scanf(uint8_t *);
  */
 trie_t *initial_read(trie_t *, uint8_t);
 
+/**
+ * @brief Reads the dictionary into a list and a hash set, for the server
+ * 
+ *  Stops at +nuova_partita or at the end of the input, then closes the input.
+ * 
+ * @param words     list to store the words in
+ * @param set       hash set to validate the words through
+ * @param wordsize  size of the words to read
+ */
+void read_dictionary(list_t *, hset_t *, uint8_t);
+
+/**
+ * @brief Parses a non negative decimal number
+ * @param line      digits to parse
+ * @param len       number of digits
+ * @return int      parsed number
+ */
+int parse_number(const char *, size_t);
+
+/**
+ * @brief Allocate and initialize requirements struct
+ * @param ref       reference string (not null terminated)
+ * @param wordsize  size of the words
+ * @return req_t*   pointer to the requirements struct
+ */
+req_t *generate_reqs(const char *, uint8_t);
+
+/**
+ * @brief Free the requirements struct and its contents
+ * @param reqs      pointer to the struct to free
+ */
+void free_reqs(req_t *);
+
+/**
+ * @brief Prints evaluation and modifies requirements accordingly
+ * @param s         guess string (not null terminated)
+ * @param wordsize  size of the words in input
+ * @param reqs      pointer to the requirements struct, delta included
+ * @return int      1 if the guess added any constraint, 0 if not
+ */
+int eval_guess(const char *, uint8_t, req_t *);
+
+/**
+ * @brief Sets a bit for each position where two strings match    O(k)
+ * @param a         first string
+ * @param b         second string
+ * @param len       number of chars to compare
+ * @param match     (len >> 6) + 1 words, bit i of word i >> 6 is set on a match
+ */
+void match_mask(const char *, const char *, uint8_t, uint64_t *);
+
+/**
+ * @brief Check word suffix based on all previous guesses
+ * @param sfx       null terminated suffix of the word
+ * @param reqs      requirements struct pointer
+ * @param hist      letter histogram of the prefix
+ * @param depth     length of the prefix
+ * @return uint8_t  1 = word is eligible    0 = word is not eligible
+ */
+uint8_t check_leaf(char *, req_t *, uint8_t *, uint8_t);
+
 /**
  * @brief Performs a full game loop
  * 
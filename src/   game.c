@@ -1,75 +1,211 @@
+#include <unistd.h>
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#endif
 #include "game.h"
+#include "list.h"
+#include "cols.h"
+#include "louds.h"
+#include "suggest.h"
+#include "hset.h"
+#include "input.h"
+#include "output.h"
+#include "pool.h"
+#include "stats.h"
 
-static void safe_fgets(char *, uint8_t);
+static char *next_line(size_t *);
 
-static req_t *generate_reqs(uint8_t);
-static void free_reqs(req_t *);
+static uint8_t enter_label(const char *, req_t *, uint8_t *, uint8_t);
+static void leave_label(const char *, uint8_t, uint8_t *);
+static int lacks_letters(uint64_t, req_t *, uint8_t *);
+static int prune_child(trie_t *, req_t *, uint8_t *, uint8_t);
+static int prune_trie(trie_t *, req_t *, uint8_t *, uint8_t);
+static void prune_worker(void *, uint8_t);
+static int prune_parallel(trie_t *, req_t *);
+static int filter_trie(trie_t *, req_t *, uint8_t *, int);
+static int filter_list(req_t *, uint8_t *);
+static uint32_t check_list(req_t *, uint8_t *, uint32_t);
+static int filter(trie_t *, req_t *, uint8_t *, int);
 
-static void eval_guess(char *, uint8_t , req_t *);
+static void reset_survivors(uint8_t);
+static record_t *listing(trie_t *, uint8_t, uint8_t);
+static void build_worker(void *, uint8_t);
+static trie_t *build_dictionary(list_t *, uint8_t);
+
+static trie_t *add_word(trie_t *, const char *, uint8_t);
+static int in_dict(trie_t *, const char *, uint8_t);
+static trie_t *handle_insert(trie_t *, uint8_t, req_t *, int *);
+
+static uint8_t engine = ENGINE_TRIE;
+static list_t *list = NULL;    // used by every engine but ENGINE_TRIE
+static cols_t *cols = NULL;    // only used by ENGINE_COLS
+static louds_t *louds = NULL;  // only used by ENGINE_LOUDS
+static hset_t *dict = NULL;    // validates guesses when there is no trie
+static input_t in;
+static uint8_t threads = 1;
+
+#define ALL_LETTERS (~(uint64_t)0)
+
+#define PAR_MIN 4096    // guesses with fewer survivors left are pruned serially
+#define PAR_BUILD 65536 // smaller dictionaries are built serially
+
+#define LISTING_FULL 0  // whole dictionary, printed before the first guess of a game
+#define LISTING_LAST 1  // survivors of the last guess
+static record_t listings[2];
+static uint8_t cached = 0;     // bit i set while listings[i] is up to date
+
+
+/** @brief Subtree two levels below the root, pruned by a single worker */
+typedef struct prune_task {
+    trie_t *node;
+    const char *prefix; // label of the node's parent
+    int res;
+} prune_task_t;
+
+/** @brief Tasks shared by the pruning workers, taken in order through next */
+typedef struct prune_job {
+    req_t *reqs;
+    prune_task_t *tasks;
+    uint32_t n_tasks;
+    uint32_t next;
+} prune_job_t;
+
+static prune_task_t tasks[CHARSET * CHARSET];
+
+/** @brief Words starting with the same letter, sorted and built by a single worker */
+typedef struct build_task {
+    uint32_t first, n;  // range of the words in the handles
+    trie_t *part;
+} build_task_t;
+
+/** @brief Tasks shared by the building workers, taken in order through next */
+typedef struct build_job {
+    list_t *words;
+    arena_t *mems;      // one arena per thread of the pool
+    build_task_t tasks[CHARSET];
+    uint8_t n_tasks;
+    uint32_t next;
+} build_job_t;
 
-static uint8_t check_leaf(char *, req_t *, uint8_t);
-static int prune_trie(trie_t *, req_t *, uint8_t);
 
-static trie_t *handle_insert(trie_t *, uint8_t);
 
 /**
- * @brief Convert characters to 0-63 interval  
- * 
- *         index = conversion_table[(int) letter]
- * 
- *  This little change got me 30L, kcachegrind reported a 5% speedup after using
- *  this to replace an equally simple function which simply saw which interval
- *  the letter is in and subtracted the appropriate amount (something like -54
- *  if A-Z etc.)
+ * @brief Returns the next input line, exits if the input ended unexpectedly
+ * @param len       set to the length of the line
+ * @return char*    start of the line (not null terminated)
  */
-static uint8_t conversion_table[128] = {
-    64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
-    64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
-    64, 64, 64, 64, 64, 64, 64, 0, 64, 64, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 64,
-    64, 64, 64, 64, 64, 64, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23,
-    24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 64, 64, 64, 64, 37, 64,
-    38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56,
-    57, 58, 59, 60, 61, 62, 63, 64, 64, 64, 64, 64
-};
-static uint8_t insert_flag = 0;
+static char *next_line(size_t *len){
+    char *line = input_line(&in, len);
+
+    if (line == NULL) exit(EXIT_FAILURE);
+    return line;
+}
 
+/**
+ * @brief Parses a non negative decimal number
+ * @param line      digits to parse
+ * @param len       number of digits
+ * @return int      parsed number
+ */
+int parse_number(const char *line, size_t len){
+    int x = 0;
+
+    for (; len > 0 && *line >= '0' && *line <= '9'; ++line, --len) x = 10*x + (*line - '0');
+    return x;
+}
+
+/**
+ * @brief Opens stdin/stdout, must be called before anything else is read
+ */
+void open_streams(void){
+    input_open(&in, STDIN_FILENO);
+    output_open(STDOUT_FILENO);
+}
+
+/**
+ * @brief Reads the size of the words from the first line
+ * @return uint8_t  size of the words
+ */
+uint8_t read_wordsize(void){
+    size_t len;
+    char *line;
+
+    line = next_line(&len);
+
+    return (uint8_t) parse_number(line, len);
+}
+
+/**
+ * @brief Selects the filtering engine, must be called before initial_read
+ * @param e         ENGINE_TRIE, ENGINE_LIST, ENGINE_COLS or ENGINE_LOUDS
+ */
+void set_engine(uint8_t e){
+    engine = e;
+}
 
-// compiler throws errors without these
-static void safe_fgets(char *s, uint8_t size){
-    if (fgets(s, size + 1, stdin) == NULL) exit(EXIT_FAILURE);
+/**
+ * @brief Uses a dictionary that was already loaded, must be called before initial_read
+ * 
+ *  The dictionary comes in the list/hash set layout (image.h), so ENGINE_TRIE
+ *  is replaced by ENGINE_LIST.
+ * 
+ * @param words     word store, with no pending words
+ * @param set       hash set of the same words
+ */
+void set_dictionary(list_t *words, hset_t *set){
+    list = words;
+    dict = set;
+    if (engine == ENGINE_TRIE) engine = ENGINE_LIST;
 }
-void safe_scanf(uint8_t *x){
-    if (scanf("%hhu\n", x) == 0) exit(EXIT_FAILURE);
+
+/**
+ * @brief Sets the number of threads used to prune the trie, starts the pool
+ * @param n         number of threads, 1 keeps pruning serial
+ */
+void set_threads(uint8_t n){
+    pool_start((n > 0) ? n : 1);
+    threads = pool_size();
 }
 
 /**
  * @brief Allocate and initialize requirements struct
+ * 
+ *  The struct, the position masks, the ref string and its letter codes are
+ *  all allocated in a single block. Every letter starts out allowed in every
+ *  position. The ref string is copied out of the input buffer, and its codes
+ *  and histogram are computed once for the whole game. The delta gets a block
+ *  of its own.
+ * 
+ * @param ref       reference string (not null terminated)
  * @param wordsize  size of the words in the trie
  * @return req_t*   pointer to the requirements struct
  */
-static req_t *generate_reqs(uint8_t wordsize){
-    req_t *reqs = (req_t *) malloc(sizeof(req_t));
-    char *match, *ref;
-    uint8_t *p, i, j;
-
-    ref = (char *)malloc((wordsize + 1) * sizeof(char));
-    safe_fgets(ref, wordsize);
-    getchar();
-    reqs->ref = ref;
-
-    match = (char *)malloc((wordsize + 1) * sizeof(char));
-    for (i = 0; i < wordsize; ++i) match[i] = '*';
-    match[wordsize] = '\0';
-    reqs->match = match;
+req_t *generate_reqs(const char *ref, uint8_t wordsize){
+    req_t *reqs = (req_t *) malloc(sizeof(req_t) + wordsize*sizeof(uint64_t) + (2*wordsize + 1)*sizeof(char));
+    req_t *delta = (req_t *) malloc(sizeof(req_t) + wordsize*sizeof(uint64_t));
+    uint8_t i;
 
-    for (i = 0; i < CHARSET; ++i) {
-        p = (uint8_t *)malloc((wordsize) * sizeof(uint8_t));
-        for (j = 0; j < wordsize; ++j) p[j] = 1;
+    if (reqs == NULL || delta == NULL) exit(EXIT_FAILURE);
+    reqs->ref = (char *)((reqs->pos) + wordsize);
+    memcpy(reqs->ref, ref, wordsize);
+    (reqs->ref)[wordsize] = '\0';
+    reqs->code = (uint8_t *)(reqs->ref + wordsize + 1);
 
-        (reqs->pos)[i]  = p;        
-        (reqs->occs)[i] = -1;
+    reqs->known = 0;
+    reqs->exact = 0;
+    memset(reqs->count, 0, sizeof(reqs->count));
+    memset(reqs->hist, 0, sizeof(reqs->hist));
+    for (i = 0; i < wordsize; ++i){
+        (reqs->pos)[i] = ALL_LETTERS;
+        (reqs->code)[i] = conversion_table[(int) ref[i]];
+        ++((reqs->hist)[(reqs->code)[i]]);
     }
 
+    // the delta shares ref with reqs, and starts out just as empty
+    memcpy(delta, reqs, sizeof(req_t) + wordsize*sizeof(uint64_t));
+    delta->delta = NULL;
+    reqs->delta = delta;
+
     return reqs;
 }
 
@@ -77,142 +213,287 @@ static req_t *generate_reqs(uint8_t wordsize){
  * @brief Free the requirements struct and its contents
  * @param reqs      pointer to the struct to free
  */
-static void free_reqs(req_t *reqs){
-    uint8_t i;
-    
-    free(reqs->ref);
-    free(reqs->match);
-    for(i = 0; i < CHARSET; ++i) free((reqs->pos)[i]);
+void free_reqs(req_t *reqs){
+    free(reqs->delta);
     free(reqs);
 }
 
+/**
+ * @brief Sets a bit for each position where two strings match
+ *
+ *  Positions are compared 16 at a time with SSE2 on x86-64, the rest one by
+ *  one. Chunks start on multiples of 16, so they never straddle two words.
+ *
+ * @param a         first string
+ * @param b         second string
+ * @param len       number of chars to compare
+ * @param match     (len >> 6) + 1 words, bit i of word i >> 6 is set on a match
+ */
+void match_mask(const char *a, const char *b, uint8_t len, uint64_t *match){
+    uint16_t i = 0;
+
+    memset(match, 0, ((len >> 6) + 1) * sizeof(uint64_t));
+#if defined(__x86_64__)
+    for (; i + 16 <= len; i += 16){
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+        match[i >> 6] |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) << (i & 63);
+    }
+#endif
+    for (; i < len; ++i) match[i >> 6] |= (uint64_t)(a[i] == b[i]) << (i & 63);
+}
+
 /** @brief Prints evaluation and modifies requirements accordingly
  *
- *  Handles both evaluation and the requirements struct:
- *  evaluation is done by counting occurrences in the ref string and then, for
- *  each character in the s string, choosing '\' or '|' based on occurrences
- *  left. It then prints the eval string.
- * 
- *  Requirements calculation happens in multiple stages:
- *      - 1st pass, REF  --> matching characters, count letters in ref (not exact)
- *      - 2nd pass, S    --> impossible positions whenever we don't have match
- *                           computes '|' and '/' of eval using occs
- *      - 3rd pass, S    --> compute occs again, with min/exact distinction
- *      - 4th pass, S    --> after computing occs, replace constraints in reqs
- *                           if occs contains stricter bounds
- * 
- * @param s         guess string.
+ *  Handles both evaluation and the requirements struct. The matching
+ *  positions are found all at once, then each of them takes its letter out of
+ *  a copy of the ref histogram. The other positions take what's left of
+ *  their letter from left to right: '|' if there is some, '/' if not.
+ * 
+ *  Whatever was taken out of the histogram is then the number of '+' and '|'
+ *  of each letter of s, and a '/' on the same letter makes the count exact.
+ *  The bounds in reqs are replaced if the new ones are stricter, and exact
+ *  bounds of 0 clear the letter from every position.
+ * 
+ *  Everything that changed is also written to reqs->delta: the new mask of
+ *  the positions whose mask shrank (the others allow every letter), and the
+ *  bounds of the letters whose bound was raised or became exact.
+ * 
+ * @param s         guess string (not null terminated)
  * @param wordsize  size of the words in input
  * @param reqs      pointer to the requirements struct.
+ * @return int      1 if the guess added any constraint, 0 if not
  */
-static void eval_guess(char *s, uint8_t wordsize, req_t *reqs){
-    int8_t occs[CHARSET] = {0};
-    char eval[wordsize + 1], *ref = reqs->ref;
-    uint8_t i, index;
+int eval_guess(const char *s, uint8_t wordsize, req_t *reqs){
+    uint8_t left[CHARSET], occs, index, has, w;
+    uint64_t match[(wordsize >> 6) + 1], missed = 0, letters = 0, fresh = 0, moved = 0, bits, bit, mask;
+    req_t *delta = reqs->delta;
+    char eval[wordsize];
+    uint16_t i;
 
-    // count char occurrences in ref and handle perfect matches
-    for(i = 0; i < wordsize; ++i){
-        index  = conversion_table[(int) ref[i]];
+    match_mask(s, reqs->ref, wordsize, match);
+    memcpy(left, reqs->hist, sizeof(left));
 
-        if (ref[i] != s[i]) ++(occs[index]);
-        else {
+    // perfect matches, their letter is already known from ref
+    for (w = 0; w <= (wordsize >> 6); ++w){
+        for (bits = match[w]; bits != 0; bits &= bits - 1){
+            i = (w << 6) + __builtin_ctzll(bits);
+            index = (reqs->code)[i];
             eval[i] = '+';
-            (reqs->match)[i] = s[i];
+            --(left[index]);
+            letters |= BIT(index);
+
+            mask = BIT(index);
+            moved |= (reqs->pos)[i] ^ mask;
+            (delta->pos)[i] = ((reqs->pos)[i] != mask) ? mask : ALL_LETTERS;
+            (reqs->pos)[i] = mask;
         }
     }
 
-    // handle imperfect matches and exclusions
-    for (i = 0; i < wordsize; ++i){
-        if (eval[i] != '+'){
+    // imperfect matches and exclusions, also impossible positions
+    for (w = 0; w <= (wordsize >> 6); ++w){
+        bits = ~match[w];
+        if ((w << 6) + 64 > wordsize) bits &= (1ULL << (wordsize & 63)) - 1;
+        for (; bits != 0; bits &= bits - 1){
+            i = (w << 6) + __builtin_ctzll(bits);
             index = conversion_table[(int) s[i]];
-            if (occs[index] == 0) eval[i] = '/';
-            else {
-                eval[i] = '|';
-                --(occs[index]);
-            }
+            bit = BIT(index);
+            has = left[index] != 0;
 
-            // get rid of impossible positions according to eval
-            (reqs->pos)[index][i] = 0;
-        }    
-    }
-    eval[wordsize] = '\0';
-
-    // once eval is computed, get the occurrences it imposes
-    for (i = 0; i < CHARSET; ++i) occs[i] = -1;
-    for (i = 0; s[i] != '\0'; ++i){
-        index = conversion_table[(int) s[i]];
-
-        if (eval[i] != '/' && occs[index] < 0) {            // '+' or '/'
-            --(occs[index]);                                // increase minimum
-        } else if (eval[i] == '+' && occs[index] >= 0) {    // '+'
-            ++(occs[index]);                                // increase exact
-        } else if (eval[i] == '/' && occs[index] < 0) {     // '/'
-            occs[index] = -(occs[index]) - 1;               // set exact
+            eval[i] = has ? '|' : '/';
+            left[index] -= has;
+            missed |= bit & ((uint64_t)has - 1);
+            letters |= bit;
+
+            mask = (reqs->pos)[i] & ~bit;
+            moved |= (reqs->pos)[i] ^ mask;
+            (delta->pos)[i] = ((reqs->pos)[i] != mask) ? mask : ALL_LETTERS;
+            (reqs->pos)[i] = mask;
         }
     }
 
-    // use occs to fix up requirements
-    for (i = 0; i < wordsize; ++i){
-        index = conversion_table[(int) s[i]];
+    // use occs to fix up requirements, exact bounds are never replaced
+    for (letters &= ~(reqs->exact); letters != 0; letters &= letters - 1){
+        index = __builtin_ctzll(letters);
+        bit = BIT(index);
+        occs = (reqs->hist)[index] - left[index];
 
-        // modify reqs->occs[index] if the new bounds are "stricter"
-        if ((reqs->occs)[index] < 0                                  &&
-            (occs[index] >= 0 || occs[index] < (reqs->occs)[index])
-        ) (reqs->occs)[index] = occs[index];
+        if (missed & bit) {                             // exact bound
+            reqs->exact |= bit;
+            fresh |= bit;
+            (reqs->count)[index] = occs;
+            if (occs > 0) reqs->known |= bit;
+            else for (i = 0; i < wordsize; ++i){
+                if ((reqs->pos)[i] & bit) (delta->pos)[i] = ((reqs->pos)[i] &= ~bit);
+            }
+        } else if (occs > (reqs->count)[index]) {       // higher minimum
+            reqs->known |= bit;
+            fresh |= bit;
+            (reqs->count)[index] = occs;
+        }
     }
 
-    puts(eval);
+    delta->known = reqs->known & fresh;
+    delta->exact = reqs->exact & fresh;
+    memcpy(delta->count, reqs->count, sizeof(delta->count));
+
+    output_line(eval, wordsize);
+    return (moved | fresh) != 0;
 }
 
 /**
- * @brief Recursively check word suffix based on all previous guesses
+ * @brief Check word suffix based on all previous guesses
  * 
- *  Recursively travels down the suffix modifying the occs array like in
- *  prune_prev(), and when it runs out it checks that the occurrences for all
- *  the letters in the ref string are either -1 or 0: this means that, while
- *  traveling down the trie, all exact/minimum occurrence bounds have been met
- *  and verifies the word.
+ *  Each letter of the suffix is tested against its position mask while being
+ *  added to a copy of the prefix histogram. Once the suffix runs out, the
+ *  histogram is compared against the bounds for all the letters in known.
  * 
  * @param sfx       suffix of the word, use a leaf node's string
  * @param reqs      requirements struct pointer
+ * @param hist      letter histogram of the prefix leading to the leaf
  * @param depth     current "level" of the trie
  * @return uint8_t  1 = word is eligible    0 = word is not eligible
  */
-static uint8_t check_leaf(char *sfx, req_t *reqs, uint8_t depth){
-    uint8_t index, res;
-    int8_t count;
-    char* ref;
-
-    // once we run out of suffix, check that all occs are either -1 or 0
-    if (sfx[0] == '\0'){
-        for (ref = (reqs->ref); *ref != '\0'; ++ref){  // iterate over occs through ref
-            index = conversion_table[(int) *ref];
-            count = (reqs->occs)[index];
-            if (count != 0 && count != -1) return 0;
+uint8_t check_leaf(char *sfx, req_t *reqs, uint8_t *hist, uint8_t depth){
+    uint8_t h[CHARSET], index;
+    uint64_t bounds;
+
+    STAT(leaves_checked, 1);
+    memcpy(h, hist, sizeof(h));
+    for (; *sfx != '\0'; ++sfx, ++depth){
+        STAT(chars_compared, 1);
+        index = conversion_table[(int) *sfx];
+        if (((reqs->pos)[depth] & BIT(index)) == 0) return 0;    // position unavailable
+        ++(h[index]);
+    }
+
+    // all exact/minimum occurrence bounds must be met
+    for (bounds = reqs->known; bounds != 0; bounds &= bounds - 1){
+        index = __builtin_ctzll(bounds);
+        if ((h[index] < (reqs->count)[index])                                  ||
+            ((reqs->exact & BIT(index)) && h[index] != (reqs->count)[index])
+        ) return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Adds the label of a branch to the prefix histogram
+ *
+ *  Stops at the first letter that can't occupy its position or would exceed
+ *  an exact bound, and takes back the letters it already added.
+ *
+ * @param label     label of the branch
+ * @param reqs      requirements struct pointer
+ * @param hist      letter histogram of the prefix leading to the branch
+ * @param depth     "level" of the first letter of the label
+ * @return uint8_t  length of the label, 0 if one of its letters fails
+ */
+static uint8_t enter_label(const char *label, req_t *reqs, uint8_t *hist, uint8_t depth){
+    uint8_t i, index;
+
+    for (i = 0; label[i] != '\0'; ++i){
+        index = conversion_table[(int) label[i]];
+        if ((((reqs->pos)[depth + i] & BIT(index)) == 0)                         ||
+            ((reqs->exact & BIT(index)) && hist[index] >= (reqs->count)[index])
+        ) {
+            leave_label(label, i, hist);
+            return 0;
         }
-        return 1;
+        ++(hist[index]);
     }
 
-    // otherwise, check that sfx[0] is compatible with the bounds
-    index = conversion_table[(int) sfx[0]];
-    count = (reqs->occs)[index];
-    if (( count == 0 )                                                      ||  // letter can't occur
-        ((reqs->match)[depth] != '*' && sfx[0] != (reqs->match)[depth])     ||  // inexact match
-        ((reqs->pos)[index][depth] == 0)                                        // position unavailable
-    ) return 0;
-    
-    // recursively call, modifying the occs array
-    if (count == -1){
-        res = check_leaf(sfx + sizeof(char), reqs, depth + 1);
-    } else if (count < -1){
-        ++((reqs->occs)[index]);
-        res = check_leaf(sfx + sizeof(char), reqs, depth + 1);
-        --((reqs->occs)[index]);
-    } else {
-        --((reqs->occs)[index]);
-        res = check_leaf(sfx + sizeof(char), reqs, depth + 1);
-        ++((reqs->occs)[index]);
+    return i;
+}
+
+/**
+ * @brief Takes the first len letters of a label out of the prefix histogram
+ * @param label     label of the branch
+ * @param len       letters to take out
+ * @param hist      letter histogram
+ */
+static void leave_label(const char *label, uint8_t len, uint8_t *hist){
+    while (len > 0) --(hist[conversion_table[(int) label[--len]]]);
+}
+
+/**
+ * @brief Checks if a subtree lacks a letter its words still need
+ *
+ *  A known letter whose minimum isn't reached by the prefix must appear
+ *  beneath it, otherwise none of the words of the subtree can pass.
+ *
+ * @param mask      letters appearing in the subtree (subtree_mask())
+ * @param reqs      requirements struct pointer
+ * @param hist      letter histogram of the prefix, label included
+ * @return int      1 if the subtree can't have valid words, 0 if it might
+ */
+static int lacks_letters(uint64_t mask, req_t *reqs, uint8_t *hist){
+    uint64_t missing;
+    uint8_t index;
+
+    for (missing = reqs->known & ~mask; missing != 0; missing &= missing - 1){
+        index = __builtin_ctzll(missing);
+        if (hist[index] < (reqs->count)[index]) return 1;
     }
+    return 0;
+}
+
+/**
+ * @brief Prunes a single node and the subtree beneath it
+ * 
+ *  A leaf is checked as a whole by check_leaf(), its label being the rest of
+ *  the word. A branch is pruned if a letter of its label can't occupy its
+ *  position or would exceed an exact bound, all of them checked at once by
+ *  enter_label(). A branch whose subtree lacks a letter still needed by the
+ *  bounds is cut off as TEMP_PRUNE, since its prefix is fine. Otherwise the
+ *  label is in the prefix histogram while the children are pruned recursively
+ *  by prune_trie().
+ * 
+ *  Nodes that are already pruned are skipped: words inserted during the game
+ *  are checked on insertion, and reset the nodes on their path if valid.
+ * 
+ * @param curr      node to prune
+ * @param reqs      requirements struct pointer
+ * @param hist      letter histogram of the prefix leading to curr
+ * @param depth     "level" of the first letter of curr
+ * @return int      number of words beneath curr that pass the bounds
+ */
+static int prune_child(trie_t *curr, req_t *reqs, uint8_t *hist, uint8_t depth){
+    char *label = curr->status + sizeof(char);
+    uint8_t len;
+    int res;
+
+    if (GET_PRUNE(curr) != NO_PRUNE) return 0;
+
+    STAT(nodes_visited, 1);
+    if (curr->branch == NULL) {     // reached a leaf
+        res = check_leaf(label, reqs, hist, depth);
+        if (res == 0) {
+            STAT(nodes_pruned, 1);
+            SET_PRUNE(curr, PRUNE);
+        }
+        return res;
+    }
+
+    // prune if a letter of the label is in an incorrect position or has no occurrences left
+    if ((len = enter_label(label, reqs, hist, depth)) == 0) {
+        STAT(nodes_pruned, 1);
+        SET_PRUNE(curr, PRUNE);
+        return 0;
+    }
+    if (lacks_letters(subtree_mask(curr, len), reqs, hist)) {
+        STAT(nodes_pruned, 1);
+        SET_PRUNE(curr, TEMP_PRUNE);
+        leave_label(label, len, hist);
+        return 0;
+    }
+
+    res = prune_trie(curr, reqs, hist, depth + len);
+
+    // resets nodes that were temporarily pruned when they get valid leaves
+    if (res > 0) SET_PRUNE(curr, NO_PRUNE);
+    else SET_PRUNE(curr, TEMP_PRUNE);
+    leave_label(label, len, hist);
 
     return res;
 }
@@ -220,12 +501,9 @@ static uint8_t check_leaf(char *sfx, req_t *reqs, uint8_t depth){
 /**
  * @brief Recursively prune the trie based on all previous guesses
  * 
- *  Travels down the trie while moving along the word, calls itself until a leaf
- *  node is found. Every time it calls itself recursively on a trie node, it
- *  modifies the occs array if the occurrences are unbound: if the word must
- *  have at least 3 "a" and we find the first "a" node, when calling the function
- *  we set occs so that, from then on, the requirement become at least 2 "a".
- *  Once a leaf is reached, the suffix is similarly checked by check_leaf().
+ *  Travels down the trie while moving along the word, pruning each child with
+ *  prune_child() until leaf nodes are found. Every time it goes down a level,
+ *  the node's label is added to the prefix histogram.
  * 
  *  This way of filtering saves a lot of time because it ignores pruned nodes,
  *  hence avoiding entire sections of the tree altogether.
@@ -233,89 +511,386 @@ static uint8_t check_leaf(char *sfx, req_t *reqs, uint8_t depth){
  *  When called on the root of the trie, returns the total number of valid nodes
  *  it contains after pruning.
  * 
- * @param trie      root of the dictionary to prune
+ * @param trie      root of the dictionary to prune (parent of the level)
  * @param reqs      requirements struct pointer
+ * @param hist      letter histogram of the current prefix, start zeroed
  * @param depth     current "level", start at 0
  * @return int      number of nodes beneath trie that pass the bounds
  */
-static int prune_trie(trie_t *trie, req_t *reqs, uint8_t depth){
-    trie_t *curr;
-    uint8_t index, res;
-    int8_t count;
+static int prune_trie(trie_t *trie, req_t *reqs, uint8_t *hist, uint8_t depth){
+    trie_t *curr = trie->branch;
+    uint8_t i, n = N_CHILDREN(trie);
     int total = 0;
-    char target;
 
-    for (curr = trie; curr != NULL; curr = curr->next){
-        
-        if (((curr->status)[0] == NO_PRUNE)                   || // valid node
-            (insert_flag && (curr->status)[0] == TEMP_PRUNE)     // potentially valid
-        ){
+    for (i = 0; i < n; ++i, ++curr) total += prune_child(curr, reqs, hist, depth);
 
-            target = (reqs->match)[depth];
-            if ((target != '*' && (curr->status)[1] == target) || (target == '*')) {
-    
-                index = conversion_table[(int) (curr->status)[1]];
-                count = (reqs->occs)[index];
-    
-                // prune if no occurrences left or incorrect position
-                if (count == 0 || (reqs->pos)[index][depth] == 0) (curr->status)[0] = PRUNE;
-                else if (curr->branch == NULL) {    // reached a leaf
-                    if (count == -1){
-                        res = check_leaf(curr->status + 2*sizeof(char), reqs, depth + 1);
-                    } else if (count < -1){
-                        ++((reqs->occs)[index]);
-                        res = check_leaf(curr->status + 2*sizeof(char), reqs, depth + 1);
-                        --((reqs->occs)[index]);
-                    } else {
-                        --((reqs->occs)[index]);
-                        res = check_leaf(curr->status + 2*sizeof(char), reqs, depth + 1);
-                        ++((reqs->occs)[index]);
-                    }
-
-                    if (res == 0) (curr->status)[0] = PRUNE;
-                    total += res;
-    
-                } else {                            // branch down
-                    if (count == -1){
-                        total += prune_trie(curr->branch, reqs, depth + 1);
-                    } else if (count < -1){
-                        ++((reqs->occs)[index]);
-                        total += prune_trie(curr->branch, reqs, depth + 1);
-                        --((reqs->occs)[index]);
-                    } else {
-                        --((reqs->occs)[index]);
-                        total += prune_trie(curr->branch, reqs, depth + 1);
-                        ++((reqs->occs)[index]);
-                    }
-
-                    // resets nodes that were temporarily pruned when they get valid leaves
-                    if ((curr->status)[0] == TEMP_PRUNE && total > 0) (curr->status)[0] = NO_PRUNE;
-                    else if (total == 0) (curr->status)[0] = TEMP_PRUNE;
-                }
-            } else (curr->status)[0] = PRUNE;
+    return total;
+}
+
+/**
+ * @brief Takes tasks from the job until there are none left
+ * 
+ *  Every worker has its own histogram, holding the label of the parent of the
+ *  task while it's pruned, and tasks are handed out one at a time so that
+ *  threads that get small subtrees simply take more of them.
+ * 
+ * @param arg       prune_job_t shared by all the workers
+ * @param id        index of the thread in the pool
+ */
+static void prune_worker(void *arg, uint8_t id){
+    prune_job_t *job = (prune_job_t *) arg;
+    prune_task_t *task;
+    uint8_t hist[CHARSET] = {0}, len;
+    uint32_t t;
+
+    (void) id;
+    while ((t = __atomic_fetch_add(&(job->next), 1, __ATOMIC_RELAXED)) < job->n_tasks){
+        task = job->tasks + t;
+        for (len = 0; (task->prefix)[len] != '\0'; ++len) ++(hist[conversion_table[(int) (task->prefix)[len]]]);
+        task->res = prune_child(task->node, job->reqs, hist, len);
+        leave_label(task->prefix, len, hist);
+    }
+}
+
+/**
+ * @brief Prunes the trie with multiple threads
+ * 
+ *  The labels of the children of the root are checked right away, and the
+ *  children of the ones that survive become the tasks: subtrees two levels down never share a
+ *  node, so the workers only have to agree on which task to take next. Once
+ *  they are done the results are summed back up into the root children, which
+ *  are reset just like prune_trie() would. The pruned nodes are exactly the
+ *  same as with a serial prune.
+ * 
+ * @param trie      root of the dictionary to prune
+ * @param reqs      requirements struct pointer
+ * @return int      number of words that pass the bounds
+ */
+static int prune_parallel(trie_t *trie, req_t *reqs){
+    trie_t *curr = trie->branch;
+    prune_job_t job = {reqs, tasks, 0, 0};
+    uint32_t start[CHARSET + 1], t;
+    uint8_t hist[CHARSET] = {0}, split[CHARSET] = {0}, len, i, j, n = N_CHILDREN(trie);
+    int total = 0, res;
+
+    for (i = 0; i < n; ++i, ++curr){
+        start[i] = job.n_tasks;
+        if (curr->branch == NULL) {         // leaves are checked right away
+            total += prune_child(curr, reqs, hist, 0);
+            continue;
+        }
+        if (GET_PRUNE(curr) != NO_PRUNE) continue;
+
+        STAT(nodes_visited, 1);
+        if ((len = enter_label(curr->status + sizeof(char), reqs, hist, 0)) == 0) {
+            STAT(nodes_pruned, 1);
+            SET_PRUNE(curr, PRUNE);
+            continue;
+        }
+        res = lacks_letters(subtree_mask(curr, len), reqs, hist);
+        leave_label(curr->status + sizeof(char), len, hist);
+        if (res) {
+            STAT(nodes_pruned, 1);
+            SET_PRUNE(curr, TEMP_PRUNE);
+            continue;
         }
+
+        split[i] = 1;
+        for (j = 0; j < N_CHILDREN(curr); ++j){
+            tasks[job.n_tasks].node = curr->branch + j;
+            tasks[job.n_tasks].prefix = curr->status + sizeof(char);
+            ++(job.n_tasks);
+        }
+    }
+    start[n] = job.n_tasks;
+
+    pool_run(prune_worker, &job);
+
+    for (i = 0, curr = trie->branch; i < n; ++i, ++curr){
+        if (!split[i]) continue;
+
+        for (res = 0, t = start[i]; t < start[i + 1]; ++t) res += tasks[t].res;
+        SET_PRUNE(curr, (res > 0) ? NO_PRUNE : TEMP_PRUNE);
+        total += res;
     }
 
     return total;
 }
 
+/**
+ * @brief Prunes the trie, in parallel if enabled and there's enough to prune
+ * 
+ *  A negative count means the trie hasn't been pruned yet in this game, so the
+ *  whole trie might be walked.
+ * 
+ * @param trie      root of the dictionary to prune
+ * @param reqs      requirements struct pointer
+ * @param hist      zeroed letter histogram
+ * @param count     survivors after the last prune
+ * @return int      number of words that pass the bounds
+ */
+static int filter_trie(trie_t *trie, req_t *reqs, uint8_t *hist, int count){
+    if (threads > 1 && (count < 0 || count > PAR_MIN)) return prune_parallel(trie, reqs);
+    return prune_trie(trie, reqs, hist, 0);
+}
+
+/**
+ * @brief Filters the survivor list based on the last guess
+ * 
+ *  Every survivor is checked as a whole word with check_leaf() and the alive
+ *  array is compacted in place, so its order is preserved.
+ * 
+ * @param reqs      requirements struct pointer
+ * @param hist      zeroed letter histogram
+ * @return int      number of survivors
+ */
+static int filter_list(req_t *reqs, uint8_t *hist){
+    uint32_t i, n = 0, *alive = list->alive;
+
+    STAT(rows_checked, list->n_alive);
+    for (i = 0; i < list->n_alive; ++i){
+        if (check_leaf(LIST_WORD(list, alive[i]), reqs, hist, 0)) alive[n++] = alive[i];
+    }
+    list->n_alive = n;
+
+    return n;
+}
+
+/**
+ * @brief Merges the words inserted mid game that pass the bounds in alive
+ * @param reqs      requirements struct pointer
+ * @param hist      zeroed letter histogram
+ * @param first     handle of the first inserted word
+ * @return uint32_t number of survivors
+ */
+static uint32_t check_list(req_t *reqs, uint8_t *hist, uint32_t first){
+    uint32_t h, n = 0, *tail = list->alive + list->n_alive;
+
+    STAT(rows_checked, list->size - first);
+    for (h = first; h < list->size; ++h){
+        if (check_leaf(LIST_WORD(list, h), reqs, hist, 0)) tail[n++] = h;
+    }
+    list_merge_alive(list, n);
+
+    return list->n_alive;
+}
+
+/**
+ * @brief Applies a guess to the survivors of whichever engine is in use
+ * 
+ *  The survivors already pass the bounds of the previous guesses (words
+ *  inserted mid game are checked against all of them), so they're only
+ *  checked against the constraints the last guess added, given in the same
+ *  form as the requirements (the delta of eval_guess()). The trie isn't
+ *  pruned again once a single word is left, since it can't be filtered any
+ *  further.
+ * 
+ * @param trie      root of the dictionary
+ * @param reqs      constraints added by the last guess
+ * @param hist      zeroed letter histogram
+ * @param count     survivors after the last guess, -1 if unknown
+ * @return int      number of survivors
+ */
+static int filter(trie_t *trie, req_t *reqs, uint8_t *hist, int count){
+    if (cols != NULL) return cols_filter(cols, reqs) + filter_list(reqs, hist);
+    if (louds != NULL) return louds_filter(louds, reqs) + filter_list(reqs, hist);
+    if (list != NULL) return filter_list(reqs, hist);
+    if (count != 1) return filter_trie(trie, reqs, hist, count);
+    return count;
+}
+
+/**
+ * @brief Starts a new game on the engines that keep the survivors in the list
+ * 
+ *  When ENGINE_LOUDS encodes the words of the list, the list and the hash set
+ *  are replaced by empty ones, so that only the words inserted from then on
+ *  are kept twice.
+ * 
+ * @param wordsize  size of the words
+ */
+static void reset_survivors(uint8_t wordsize){
+    list_reset(list);
+    if (cols != NULL) cols_reset(cols, list);
+    if (louds != NULL && louds_reset(louds, list)) {
+        list_free(list);
+        hset_free(dict);
+        list = list_init(wordsize);
+        dict = hset_init(list);
+    }
+}
+
+/**
+ * @brief Takes tasks from the job until there are none left
+ * 
+ *  The words of a task only share their first letter, so they're sorted from
+ *  the second one on, in their own range of the handles and of the scratch
+ *  array, and built into a part in the arena of the thread.
+ * 
+ * @param arg       build_job_t shared by all the workers
+ * @param id        index of the thread in the pool
+ */
+static void build_worker(void *arg, uint8_t id){
+    build_job_t *job = (build_job_t *) arg;
+    list_t *words = job->words;
+    build_task_t *task;
+    uint32_t t;
+
+    while ((t = __atomic_fetch_add(&(job->next), 1, __ATOMIC_RELAXED)) < job->n_tasks){
+        task = job->tasks + t;
+        list_sort(words, words->dict + task->first, words->tmp + task->first, task->n, 1);
+        task->part = build_trie(job->mems + id, words->words, words->dict + task->first, task->n, words->wordsize);
+    }
+}
+
+/**
+ * @brief Builds the trie of the initial dictionary
+ * 
+ *  Serially the words are sorted by list_reset() and built by build_trie().
+ *  With more threads and a big enough dictionary, the words are first split
+ *  by their first letter with a counting pass, and every letter becomes a task
+ *  that is sorted and built on its own, in the arena of whichever worker takes
+ *  it. The parts are then joined under the root in the order of the letters.
+ * 
+ * @param words     list with every word of the dictionary, left unsorted
+ * @param wordsize  size of the words
+ * @return trie_t*  root of the trie
+ */
+static trie_t *build_dictionary(list_t *words, uint8_t wordsize){
+    uint32_t start[CHARSET + 1] = {0}, next[CHARSET], h;
+    build_job_t job;
+    trie_t *parts[CHARSET], *trie;
+    uint8_t c, i;
+
+    if (threads == 1 || words->size < PAR_BUILD) {
+        list_reset(words);
+        return build_trie(NULL, words->words, words->dict, words->n_dict, wordsize);
+    }
+
+    for (h = 0; h < words->size; ++h) ++(start[conversion_table[(int) LIST_WORD(words, h)[0]] + 1]);
+    for (c = 0; c < CHARSET; ++c){
+        start[c + 1] += start[c];
+        next[c] = start[c];
+    }
+    for (h = 0; h < words->size; ++h) (words->dict)[next[conversion_table[(int) LIST_WORD(words, h)[0]]]++] = h;
+
+    job.words = words;
+    job.n_tasks = 0;
+    job.next = 0;
+    for (c = 0; c < CHARSET; ++c){
+        if (start[c + 1] == start[c]) continue;
+        job.tasks[job.n_tasks].first = start[c];
+        job.tasks[job.n_tasks].n = start[c + 1] - start[c];
+        ++(job.n_tasks);
+    }
+
+    job.mems = (arena_t *)calloc(threads, sizeof(arena_t));
+    if (job.mems == NULL) exit(EXIT_FAILURE);
+    pool_run(build_worker, &job);
+
+    for (i = 0; i < job.n_tasks; ++i) parts[i] = job.tasks[i].part;
+    trie = join_tries(parts, job.n_tasks, job.mems, threads);
+    free(job.mems);
+
+    return trie;
+}
+
+/**
+ * @brief Inserts a word in the dictionary
+ * 
+ *  With ENGINE_TRIE the word goes in the trie, which is also used to validate
+ *  guesses. The other engines only need the trie for that, so they put the
+ *  word in the list and in the hash set instead, and the trie is never built.
+ * 
+ * @param trie      root of the trie to insert the word into
+ * @param word      word to insert
+ * @param wordsize  size of the word
+ * @return trie_t*  root of the trie after insertion
+ */
+static trie_t *add_word(trie_t *trie, const char *word, uint8_t wordsize){
+    if (list != NULL) {
+        hset_add(dict, list_add(list, word));
+        return trie;
+    }
+    return insert(trie, word, wordsize, NO_PRUNE);
+}
+
+/**
+ * @brief Returns the listing of the survivors, printing them only if needed
+ *
+ *  Printing walks the whole dictionary, while the survivors only change with
+ *  a guess or an insertion. The output of a walk is recorded, and reused by
+ *  the next +stampa_filtrate or +suggerisci that finds it still up to date.
+ *  Before the first guess of a game every word survives, so that listing is
+ *  kept apart and stays valid across games until a word is inserted.
+ *
+ * @param trie      root of the dictionary
+ * @param wordsize  size of the words in the trie
+ * @param which     LISTING_FULL or LISTING_LAST
+ * @return record_t* survivors in order, a line of wordsize + 1 chars each
+ */
+static record_t *listing(trie_t *trie, uint8_t wordsize, uint8_t which){
+    if (cached & BIT(which)) return listings + which;
+
+    output_record(listings + which);
+    if (cols != NULL) cols_print(cols, list);
+    else if (louds != NULL) louds_print(louds, list);
+    else if (list != NULL) list_print(list);
+    else print_trie(trie, wordsize);
+    output_stop();
+    cached |= BIT(which);
+
+    return listings + which;
+}
+
+/**
+ * @brief Checks if a guess is in the dictionary
+ * @param trie      root of the dictionary
+ * @param word      guess to look for
+ * @param wordsize  size of the word
+ * @return int      1 if found, 0 if not
+ */
+static int in_dict(trie_t *trie, const char *word, uint8_t wordsize){
+    if (louds != NULL && louds_search(louds, word)) return 1;
+    if (dict != NULL) return hset_contains(dict, word);
+    return search(trie, word, wordsize);
+}
+
 /**
  * @brief Reads and inserts words into dictionary until +inserisci_fine
+ * 
+ *  When reqs is given (ENGINE_TRIE, during a game) each word is checked
+ *  against the requirements right away and inserted already pruned or not, so
+ *  the trie never needs to be walked again for the new words. Valid words are
+ *  added to count, unless the trie hasn't been pruned yet (negative count).
+ * 
  * @param trie      root of the trie to insert the words into
  * @param wordsize  size of the words to read
+ * @param reqs      requirements of the current game, NULL if not needed
+ * @param count     number of valid words, updated if reqs is given
  * @return trie_t*  root of the trie after insertion
  */
-static trie_t *handle_insert(trie_t *trie, uint8_t wordsize){
-    char buff[wordsize + 1];
+static trie_t *handle_insert(trie_t *trie, uint8_t wordsize, req_t *reqs, int *count){
+    uint8_t hist[CHARSET] = {0};
+    char word[wordsize + 1];
+    size_t len;
+    char *line;
 
-    safe_fgets(buff, wordsize);
-    while (buff[0] != '+'){
-        trie = insert(trie, buff);
+    word[wordsize] = '\0';
+    for (line = next_line(&len); line[0] != '+'; line = next_line(&len)){
+        cached = 0;     // both listings are missing the word
+        if (reqs == NULL) {
+            trie = add_word(trie, line, wordsize);
+            continue;
+        }
 
-        getchar(); //trailing \n
-        safe_fgets(buff, wordsize);
+        memcpy(word, line, wordsize);
+        if (check_leaf(word, reqs, hist, 0)) {
+            trie = insert(trie, word, wordsize, NO_PRUNE);
+            if (*count >= 0) ++(*count);
+        } else {
+            trie = insert(trie, word, wordsize, PRUNE);
+        }
     }
-    if (wordsize <= 15) while (getchar() != '\n');
 
     return trie;
 }
@@ -328,41 +903,83 @@ static trie_t *handle_insert(trie_t *trie, uint8_t wordsize){
  *  in the initial dictionary and simply dumps the +inserisci_inizio and 
  *  +inserisci_fine stirngs.
  * 
+ *  With ENGINE_TRIE the words are collected in a temporary list, radix sorted
+ *  and built into the trie in one pass (build_dictionary()).
+ * 
  * @param trie      root of the trie to insert the words into (should be NULL)
  * @param wordsize  size of the words to read
  * @return trie_t*  root of the trie after insertion
  */
 trie_t *initial_read(trie_t *trie, uint8_t wordsize){
-    char *buff = (char *) malloc((wordsize + 1) * sizeof(char));
+    list_t *words = NULL;
+    size_t len;
+    char *line;
 
-    safe_fgets(buff, wordsize);
-    while (buff[0] != '+'){
-        trie = insert(trie, buff);
+    if (engine != ENGINE_TRIE && list == NULL) {
+        list = list_init(wordsize);
+        dict = hset_init(list);
+    }
+    if (engine == ENGINE_COLS) cols = cols_init(wordsize);
+    if (engine == ENGINE_LOUDS) louds = louds_init(wordsize);
+    if (engine == ENGINE_TRIE && trie == NULL) words = list_init(wordsize);
 
-        getchar(); //trailing \n
-        safe_fgets(buff, wordsize);
+    // the words read here are validated by the succinct trie once it's built
+    for (line = next_line(&len); !IS_CMD(line, len, NEW_GAME); line = next_line(&len)){
+        if (line[0] == '+') continue;
+        if (words != NULL) list_add(words, line);
+        else if (louds != NULL) list_add(list, line);
+        else trie = add_word(trie, line, wordsize);
     }
 
-    if (buff[1] == 'n'){    // +nuova_partita
-        if (wordsize <= 14) while (getchar() != '\n');
-    } else {                // +inserisci_inizio
-        if (wordsize <= 17) while (getchar() != '\n');
-        trie = handle_insert(trie, wordsize);
-        while(getchar() != '\n');
+    if (words != NULL) {
+        trie = build_dictionary(words, wordsize);
+        list_free(words);
     }
-    free(buff);
+    STAT_CMD(STAT_RESET);
 
     return trie;
 }
+
+/**
+ * @brief Reads the dictionary into a list and a hash set, for the server
+ * 
+ *  As in initial_read(), words inserted before the first game are part of the
+ *  dictionary. Reading stops at +nuova_partita or at the end of the input, and
+ *  the input is closed since nothing else is read from it.
+ * 
+ * @param words     list to store the words in
+ * @param set       hash set to validate the words through
+ * @param wordsize  size of the words to read
+ */
+void read_dictionary(list_t *words, hset_t *set, uint8_t wordsize){
+    size_t len;
+    char *line;
+
+    for (line = input_line(&in, &len); line != NULL && !IS_CMD(line, len, NEW_GAME); line = input_line(&in, &len)){
+        if (len == wordsize && line[0] != '+') {
+            hset_add(set, list_add(words, line));
+        }
+    }
+    input_close(&in);
+}
+
 /**
  * @brief Performs a full game loop
  * 
  *  By far the ugliest function in the entire project, but very functional.
  *  Each iteration reads an input line, which can either be a command or a guess.
  *  
- *      +inserisci_inizio: inserts to the dictionary and sets an insert flag
- *      +stampa_filtrate:  prints the dictionary. if the insert flag was set
- *                         it first does a full prune of the dictionary
+ *      +inserisci_inizio: inserts to the dictionary, checking each word on the
+ *                         way in so that the count stays up to date
+ *      +stampa_filtrate:  prints the dictionary
+ *      +suggerisci:       prints the survivors that are the best next guesses
+ * 
+ *  With ENGINE_LIST the survivors are kept in the list instead: inserted words
+ *  are checked right away and merged in, and the trie is never pruned.
+ *  ENGINE_COLS filters the columns built at the start of the game, and keeps
+ *  only the words inserted during the game in the list. ENGINE_LOUDS does the
+ *  same with the succinct trie, whose list holds every word inserted since it
+ *  was last built.
  * 
  *  Guesses are first checked against the ref string, then searched in the
  *  dictionary, and only then the evaluation is computed. 
@@ -377,70 +994,89 @@ trie_t *initial_read(trie_t *trie, uint8_t wordsize){
  */
 trie_t *new_game(trie_t *trie, uint8_t wordsize){
     req_t *reqs;
-    uint8_t guesses;
-    int count = 0;
-    char buff[wordsize + 1];
-    char dump[18];
+    int guesses, rounds, count = -1;   // unknown until the first prune
+    uint32_t first;
+    uint8_t hist[CHARSET] = {0}, found, fresh;
+    record_t *rec;
+    size_t len;
+    char *line;
 
-    insert_flag = 0;                // reset insert flag
-    reqs = generate_reqs(wordsize); // init reqs, reads ref
-    safe_scanf(&guesses);           // read guesses
+    line = next_line(&len);         // read ref
+    reqs = generate_reqs(line, wordsize);
+    line = next_line(&len);         // read guesses
+    guesses = parse_number(line, len);
+    rounds = guesses;
+    if (list != NULL) TIMED(LAT_RESET, reset_survivors(wordsize));
 
     while(guesses > 0){
-        safe_fgets(buff, wordsize);
+        line = next_line(&len);
 
-        if(buff[0] == '+'){
+        if(line[0] == '+'){
     
-            if (buff[1] == 's'){                        // +stampa_filtrate
-                if (wordsize <= 16) while (getchar() != '\n');
-
-                if (insert_flag) {
-                    count = prune_trie(trie, reqs, 0);
-                    insert_flag = 0;                    // reset insert flag
-                }
-                print_trie(trie, wordsize);
+            if (IS_CMD(line, len, PRINT)){
+                STAT_CMD(STAT_PRINT);
+                TIMED(LAT_PRINT, output_replay(listing(trie, wordsize, (guesses == rounds) ? LISTING_FULL : LISTING_LAST)));
 
-            } else if (buff[1] == 'i'){                 // +inserisci_inizio
-                if (wordsize <= 17) while (getchar() != '\n');
+            } else if (IS_CMD(line, len, SUGGEST)){
+                STAT_CMD(STAT_SUGGEST);
+                TIMED(LAT_SUGGEST,
+                    rec = listing(trie, wordsize, (guesses == rounds) ? LISTING_FULL : LISTING_LAST);
+                    suggest(rec->text, rec->len / (wordsize + 1), wordsize, 1));
 
-                trie = handle_insert(trie, wordsize);
-                insert_flag = 1;                        // set insert flag
-                count = 0;                              // reset count
+            } else if (IS_CMD(line, len, INSERT_START)){
+                STAT_CMD(STAT_INSERT);
+                if (list != NULL) {
+                    first = list->size;
+                    TIMED(LAT_INSERT,
+                        trie = handle_insert(trie, wordsize, NULL, NULL);
+                        count = check_list(reqs, hist, first)); // merge survivors
+                    if (cols != NULL) count += cols->n_live;
+                    else if (louds != NULL) count += louds->n_live;
+                } else {
+                    TIMED(LAT_INSERT, trie = handle_insert(trie, wordsize, reqs, &count));
+                }
             }
 
         } else{
 
-            getchar(); // trailing newline for words
-
-            if (strcmp(reqs->ref, buff) == 0) {         // guessed correctly
-                puts("ok");
+            STAT_CMD(STAT_GUESS);
+            if (memcmp(reqs->ref, line, wordsize) == 0) {  // guessed correctly
+                OUTPUT_STR("ok");
                 break;
-            } else if (search(trie, buff) == 0) {       // word not in dict
-                puts("not_exists");
-            } else {
-                eval_guess(buff, wordsize, reqs);       // print eval, get reqs
+            }
 
-                if (count != 1) count = prune_trie(trie, reqs, 0);
-                if (insert_flag) insert_flag = 0;       // fixed TEMP_PRUNE
+            TIMED(LAT_SEARCH, found = in_dict(trie, line, wordsize));
+            if (!found) {                                   // word not in dict
+                OUTPUT_STR("not_exists");
+            } else {
+                TIMED(LAT_EVAL, fresh = eval_guess(line, wordsize, reqs)); // print eval, get reqs
+                cached &= ~BIT(LISTING_LAST);
+                if (fresh || count < 0) {                   // nothing to filter otherwise
+                    TIMED((guesses == rounds) ? LAT_FIRST : LAT_FILTER, count = filter(trie, reqs->delta, hist, count));
+                }
                 
-                printf("%d\n", count);
+                output_number(count);
                 --guesses;
             }
         }
     }
-    if (guesses == 0) puts("ko");
-
-    if (getchar() == EOF) exit(EXIT_SUCCESS);
-    else {
-        safe_fgets(dump, 17);
+    if (guesses == 0) OUTPUT_STR("ko");
+    stats_game_end();
 
-        if (dump[0] == 'i'){
-            trie = handle_insert(trie, wordsize);
-            safe_fgets(dump, 17);
+    // only insertions can be found before the next game
+    line = input_line(&in, &len);
+    while (line != NULL && !IS_CMD(line, len, NEW_GAME)){
+        if (IS_CMD(line, len, INSERT_START)) {
+            STAT_CMD(STAT_INSERT);
+            TIMED(LAT_INSERT, trie = handle_insert(trie, wordsize, NULL, NULL));
         }
+        line = input_line(&in, &len);
+    }
+    if (line == NULL) exit(EXIT_SUCCESS);
+    STAT_CMD(STAT_RESET);
 
-        // free/clear only when restarting
-        free_reqs(reqs);
-        clear_trie(trie);
-    } return trie;
+    // free/clear only when restarting
+    free_reqs(reqs);
+    if (list == NULL) TIMED(LAT_RESET, clear_trie(trie));
+    return trie;
 }
@@ -1,12 +1,82 @@
+#include <unistd.h>
+#include <getopt.h>
 #include "trie.h"
 #include "game.h"
+#include "stats.h"
+#include "server.h"
+#include "image.h"
 
+#define MAX_THREADS 64
+#define OPT_STATS 256   // long only options
+#define OPT_SERVER 257
+#define OPT_IMAGE 258
+#define OPT_SAVE_IMAGE 259
 
-int main(){
+static const struct option options[] = {
+    {"stats", no_argument, NULL, OPT_STATS},
+    {"server", required_argument, NULL, OPT_SERVER},
+    {"image", required_argument, NULL, OPT_IMAGE},
+    {"save-image", required_argument, NULL, OPT_SAVE_IMAGE},
+    {NULL, 0, NULL, 0}
+};
+
+
+int main(int argc, char *argv[]){
     trie_t *trie = NULL;
-    uint8_t wordsize;
+    list_t *words = NULL;
+    hset_t *set = NULL;
+    const char *sock_path = NULL, *image = NULL, *save = NULL;
+    uint8_t wordsize, jobs = 1;
+    int opt;
+
+    // -e trie|list|cols|louds selects the filtering engine, -j the threads used to build and prune,
+    // --stats reports the counters of a STATS build on stderr, --server loads the
+    // dictionary and serves games on a socket, to -j sessions at a time, --save-image
+    // writes the dictionary to an image and exits, --image maps it instead of reading
+    // a dictionary from the input (which then starts with the games)
+    while ((opt = getopt_long(argc, argv, "e:j:", options, NULL)) != -1){
+        if (opt == 'e' && strcmp(optarg, "trie") == 0) set_engine(ENGINE_TRIE);
+        else if (opt == 'e' && strcmp(optarg, "list") == 0) set_engine(ENGINE_LIST);
+        else if (opt == 'e' && strcmp(optarg, "cols") == 0) set_engine(ENGINE_COLS);
+        else if (opt == 'e' && strcmp(optarg, "louds") == 0) set_engine(ENGINE_LOUDS);
+        else if (opt == 'j' && atoi(optarg) > 0 && atoi(optarg) <= MAX_THREADS) jobs = atoi(optarg);
+        else if (opt == OPT_SERVER) sock_path = optarg;
+        else if (opt == OPT_IMAGE) image = optarg;
+        else if (opt == OPT_SAVE_IMAGE) save = optarg;
+        else if (opt == OPT_STATS && stats_enable() != 0) {
+            fprintf(stderr, "%s: --stats needs a build with -DSTATS (make stats)\n", argv[0]);
+            return EXIT_FAILURE;
+        } else if (opt != OPT_STATS) {
+            fprintf(stderr, "usage: %s [-e trie|list|cols|louds] [-j threads] [--stats] [--server socket] "
+                            "[--image file | --save-image file]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    open_streams();
+    if (image != NULL && image_load(image, &words, &set) != 0) {
+        fprintf(stderr, "%s: can't load the image %s\n", argv[0], image);
+        return EXIT_FAILURE;
+    }
+    wordsize = (words != NULL) ? words->wordsize : read_wordsize();
 
-    safe_scanf(&wordsize);
+    if (words == NULL && (save != NULL || sock_path != NULL)) {
+        words = list_init(wordsize);
+        set = hset_init(words);
+        read_dictionary(words, set, wordsize);
+        list_reset(words);
+    }
+    if (save != NULL) {
+        if (image_save(save, words, set) == 0) return EXIT_SUCCESS;
+        perror(save);
+        return EXIT_FAILURE;
+    }
+    if (sock_path != NULL) {
+        serve(sock_path, words, set, jobs);
+        return EXIT_SUCCESS;
+    }
+    if (words != NULL) set_dictionary(words, set);
+    set_threads(jobs);
 
     trie = initial_read(trie, wordsize);
 
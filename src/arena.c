@@ -0,0 +1,231 @@
+#include "arena.h"
+#include "stats.h"
+
+static char *new_chunk(arena_t *, size_t);
+static void push_block(arena_t *, void *, size_t);
+static void *take_block(arena_t *, size_t);
+
+
+/**
+ * @brief Requests a new chunk from the system and links it to the arena
+ * @param arena     arena to grow
+ * @param size      minimum amount of usable bytes
+ * @return char*    start of the usable area of the chunk
+ */
+static char *new_chunk(arena_t *arena, size_t size){
+    chunk_t *chunk;
+
+    if (size < ARENA_CHUNK) size = ARENA_CHUNK;
+    chunk = (chunk_t *)malloc(sizeof(chunk_t) + size);
+    if (chunk == NULL) exit(EXIT_FAILURE);
+
+    chunk->prev = arena->chunks;
+    chunk->size = size;
+    arena->chunks = chunk;
+    arena->reserved += sizeof(chunk_t) + size;
+
+    return (char *)(chunk + 1);
+}
+
+/**
+ * @brief Pushes a block in the free list of its size class
+ * @param arena     arena the block belongs to
+ * @param block     block to release
+ * @param cls       size of the block in ARENA_ALIGN units
+ */
+static void push_block(arena_t *arena, void *block, size_t cls){
+    *(void **)block = arena->free_block[cls];
+    arena->free_block[cls] = block;
+    arena->block_map[cls / 64] |= (uint64_t)1 << (cls % 64);
+}
+
+/**
+ * @brief Takes a released block of at least cls units, if there is one
+ *
+ *  The exact size is preferred, otherwise the smallest bigger block is split
+ *  and the remainder goes back in its free list. Child arrays are released
+ *  every time they grow by one, so without splitting the arrays left behind by
+ *  the last nodes to grow would never be used again.
+ *
+ * @param arena     arena to take the block from
+ * @param cls       size of the block in ARENA_ALIGN units
+ * @return void*    pointer to the block, NULL if there's none big enough
+ */
+static void *take_block(arena_t *arena, size_t cls){
+    size_t i = cls / 64, c;
+    uint64_t mask = arena->block_map[i] & (~(uint64_t)0 << (cls % 64));
+    void *block;
+
+    while (mask == 0){
+        if (++i == ARENA_BLOCKS / 64) return NULL;
+        mask = arena->block_map[i];
+    }
+    c = 64*i + __builtin_ctzll(mask);
+
+    block = arena->free_block[c];
+    arena->free_block[c] = *(void **)block;
+    if (arena->free_block[c] == NULL) arena->block_map[i] &= ~((uint64_t)1 << (c % 64));
+
+    if (c > cls) push_block(arena, (char *)block + cls*ARENA_ALIGN, c - cls);
+    return block;
+}
+
+/**
+ * @brief Allocates size bytes aligned for any node type
+ *
+ *  Nodes get their own chunks so that they stay packed together instead of
+ *  being interleaved with the status strings. Released blocks are handed out
+ *  first, and the unused end of a chunk is released when a new one is needed.
+ *
+ * @param arena     arena to allocate from
+ * @param size      size of the block
+ * @return void*    pointer to the block
+ */
+void *arena_alloc(arena_t *arena, size_t size){
+    char *block;
+
+    size = (size + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1);
+    arena->used += size;
+    STAT(allocs, 1);
+    STAT(alloc_bytes, size);
+    if (size / ARENA_ALIGN < ARENA_BLOCKS && (block = take_block(arena, size / ARENA_ALIGN)) != NULL){
+        return block;
+    }
+
+    if ((size_t)(arena->node_end - arena->node_top) < size){
+        if (arena->node_top != NULL && arena->node_top != arena->node_end) {
+            arena->used += arena->node_end - arena->node_top;
+            arena_free(arena, arena->node_top, arena->node_end - arena->node_top);
+        }
+        arena->node_top = new_chunk(arena, size);
+        arena->node_end = arena->node_top + arena->chunks->size;
+    }
+
+    block = arena->node_top;
+    arena->node_top += size;
+
+    return block;
+}
+
+/**
+ * @brief Releases a block obtained from arena_alloc()
+ *
+ *  Blocks bigger than the last size class are simply left where they are.
+ *
+ * @param arena     arena the block belongs to
+ * @param block     block to release
+ * @param size      size the block was allocated with
+ */
+void arena_free(arena_t *arena, void *block, size_t size){
+
+    size = (size + ARENA_ALIGN - 1) & ~((size_t)ARENA_ALIGN - 1);
+    arena->used -= size;
+    if (size / ARENA_ALIGN < ARENA_BLOCKS) push_block(arena, block, size / ARENA_ALIGN);
+}
+
+/**
+ * @brief Allocates an unaligned string of exactly size bytes
+ *
+ *  Recycled strings of the same size are preferred, otherwise the string is
+ *  cut from the current byte chunk. Whatever is left at the end of a chunk when
+ *  it runs out is put in the free list of its size.
+ *
+ * @param arena     arena to allocate from
+ * @param size      size of the string (at most ARENA_CLASSES - 1)
+ * @return char*    pointer to the string
+ */
+char *arena_str(arena_t *arena, size_t size){
+    char *str = arena->free[size];
+    size_t cls;
+
+    arena->used += size;
+    STAT(allocs, 1);
+    STAT(alloc_bytes, size);
+    if (str != NULL){   // pop from free list, the link is stored unaligned
+        memcpy(&(arena->free[size]), str, sizeof(char *));
+        return str;
+    }
+
+    if ((size_t)(arena->str_end - arena->str_top) < size){
+        if (arena->str_top != NULL) {   // keep the leftover bytes around
+            arena->used += arena->str_end - arena->str_top;
+            arena_free_str(arena, arena->str_top, arena->str_end - arena->str_top);
+        }
+
+        // released node blocks are used up before asking for a new chunk
+        cls = (size + ARENA_ALIGN - 1) / ARENA_ALIGN;
+        if ((arena->str_top = take_block(arena, cls)) != NULL) {
+            arena->str_end = arena->str_top + cls*ARENA_ALIGN;
+        } else {
+            arena->str_top = new_chunk(arena, 0);
+            arena->str_end = arena->str_top + arena->chunks->size;
+        }
+    }
+
+    str = arena->str_top;
+    arena->str_top += size;
+
+    return str;
+}
+
+/**
+ * @brief Releases a string obtained from arena_str()
+ *
+ *  Strings too small to hold the free list link are simply dropped, they are
+ *  only a handful of bytes and they go away with the arena anyway.
+ *
+ * @param arena     arena the string belongs to
+ * @param str       string to release
+ * @param size      size the string was allocated with
+ */
+void arena_free_str(arena_t *arena, char *str, size_t size){
+
+    arena->used -= size;
+    if (size < sizeof(char *)) return;
+
+    memcpy(str, &(arena->free[size]), sizeof(char *));
+    arena->free[size] = str;
+}
+
+/**
+ * @brief Shrinks a string in place, releasing its tail
+ * @param arena     arena the string belongs to
+ * @param str       string to shrink
+ * @param size      size the string was allocated with
+ * @param new_size  new size of the string
+ */
+void arena_shrink_str(arena_t *arena, char *str, size_t size, size_t new_size){
+    if (new_size < size) arena_free_str(arena, str + new_size, size - new_size);
+}
+
+/**
+ * @brief Moves every chunk of an arena into another one
+ * @param dst       arena taking the chunks
+ * @param src       arena giving them away, left empty
+ */
+void arena_adopt(arena_t *dst, arena_t *src){
+    chunk_t *last = src->chunks;
+
+    if (last != NULL) {
+        while (last->prev != NULL) last = last->prev;
+        last->prev = dst->chunks;
+        dst->chunks = src->chunks;
+    }
+    dst->used += src->used;
+    dst->reserved += src->reserved;
+    memset(src, 0, sizeof(arena_t));
+}
+
+/**
+ * @brief Frees every chunk of the arena and resets it
+ * @param arena     arena to release
+ */
+void arena_release(arena_t *arena){
+    chunk_t *chunk = arena->chunks, *prev;
+
+    for (; chunk != NULL; chunk = prev){
+        prev = chunk->prev;
+        free(chunk);
+    }
+    memset(arena, 0, sizeof(arena_t));
+}
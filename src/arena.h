@@ -0,0 +1,127 @@
+/**
+ * @file arena.h
+ * @author Andrea Sgobbi
+ * @date 16 October 2026
+ * @brief Header containing the arena allocator used for the dictionary
+ *
+ *  Every trie node used to cost two mallocs (node + status), which on the big
+ *  tests means millions of tiny heap blocks, each with its own 16B allocator
+ *  header and scattered all over the heap. The arena instead hands out memory
+ *  from large chunks:
+ *
+ *      - nodes are bump allocated from dedicated chunks, so they end up packed
+ *        next to each other in insertion order. Blocks released with
+ *        arena_free() go in a free list for their size, which is how the
+ *        child arrays of the trie get recycled when they grow
+ *      - status strings come from a separate byte area, with one free list
+ *        per exact size so that bytes released by split_leaves() get reused
+ *
+ *  Nothing is ever returned to the system until arena_release(), which drops
+ *  the whole dictionary at once.
+ */
+#ifndef ARENA_H_
+#define ARENA_H_
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define ARENA_CHUNK (1 << 20)   // default chunk size in bytes
+#define ARENA_CLASSES 266       // max status size is 255 chars + prune + '\0' + mask
+#define ARENA_ALIGN 8
+#define ARENA_BLOCKS 256        // aligned blocks up to 2KiB are recycled
+
+
+/** @brief Chunk of memory owned by an arena, chained to the previous one */
+typedef struct chunk {
+    struct chunk *prev;
+    size_t size;
+} chunk_t;
+
+/** @brief Arena allocator
+ *
+ *      ARENA:
+ *
+ *  - chunks:           list of all the chunks, most recent first
+ *  - node_top/end:     bump area for fixed size, aligned allocations (nodes)
+ *  - str_top/end:      bump area for unaligned byte strings
+ *  - free_block[n]:    list of released aligned blocks of n*ARENA_ALIGN bytes
+ *  - block_map:        bit n is set if free_block[n] is not empty
+ *  - free[n]:          list of released strings of exactly n bytes. The link
+ *                      is stored in the string itself, so only sizes that can
+ *                      hold a pointer are ever recycled
+ *  - used:             bytes handed out and not released
+ *  - reserved:         bytes requested from the system
+ *
+ *  A zeroed arena_t is a valid empty arena.
+ */
+typedef struct arena {
+    chunk_t *chunks;
+    char *node_top, *node_end;
+    char *str_top, *str_end;
+    void *free_block[ARENA_BLOCKS];
+    uint64_t block_map[ARENA_BLOCKS / 64];
+    char *free[ARENA_CLASSES];
+    size_t used;
+    size_t reserved;
+} arena_t;
+
+/**
+ * @brief Allocates size bytes aligned for any node type          O(1)
+ * @param arena     arena to allocate from
+ * @param size      size of the block
+ * @return void*    pointer to the block
+ */
+void *arena_alloc(arena_t *, size_t);
+
+/**
+ * @brief Releases a block obtained from arena_alloc()            O(1)
+ * @param arena     arena the block belongs to
+ * @param block     block to release
+ * @param size      size the block was allocated with
+ */
+void arena_free(arena_t *, void *, size_t);
+
+/**
+ * @brief Allocates an unaligned string of exactly size bytes     O(1)
+ * @param arena     arena to allocate from
+ * @param size      size of the string (at most ARENA_CLASSES - 1)
+ * @return char*    pointer to the string
+ */
+char *arena_str(arena_t *, size_t);
+
+/**
+ * @brief Releases a string obtained from arena_str()             O(1)
+ * @param arena     arena the string belongs to
+ * @param str       string to release
+ * @param size      size the string was allocated with
+ */
+void arena_free_str(arena_t *, char *, size_t);
+
+/**
+ * @brief Shrinks a string in place, releasing its tail           O(1)
+ * @param arena     arena the string belongs to
+ * @param str       string to shrink
+ * @param size      size the string was allocated with
+ * @param new_size  new size of the string
+ */
+void arena_shrink_str(arena_t *, char *, size_t, size_t);
+
+/**
+ * @brief Moves every chunk of an arena into another one          O(chunks)
+ *
+ *  Lets a thread build part of a structure in an arena of its own, and then
+ *  hand the memory over to the arena of the whole structure. The free lists
+ *  and the unused ends of the moved chunks are dropped, src is left empty.
+ *
+ * @param dst       arena taking the chunks
+ * @param src       arena giving them away
+ */
+void arena_adopt(arena_t *, arena_t *);
+
+/**
+ * @brief Frees every chunk of the arena and resets it            O(chunks)
+ * @param arena     arena to release
+ */
+void arena_release(arena_t *);
+
+#endif
@@ -0,0 +1,194 @@
+/**
+ * @file gen.c
+ * @author Andrea Sgobbi
+ * @date 17 October 2026
+ * @brief Deterministic workload generator for the benchmarks
+ *
+ *  Writes a complete input (word size, dictionary, games) to stdout. The same
+ *  seed always gives the same dictionary and the same games, whatever the
+ *  print and insertion frequencies are: every part of the input is drawn from
+ *  its own random stream, so the harness can compare runs that only differ in
+ *  one kind of command.
+ *
+ *      usage: gen [-k wordsize] [-n words] [-g games] [-t guesses]
+ *                 [-i insert_every] [-w insert_words] [-p print_every]
+ *                 [-a alphabet] [-s seed] [-q]
+ *
+ *  -i and -p are in guesses (0 = never), -q makes every game end on its first
+ *  guess, which is the reference word.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+// all the symbols allowed by the project, in ASCII order
+static const char symbols[] = "-0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ_abcdefghijklmnopqrstuvwxyz";
+
+/** @brief Parameters of the workload, see the usage above */
+typedef struct params {
+    uint32_t wordsize, words, games, guesses;
+    uint32_t insert_every, insert_words, print_every;
+    uint32_t alphabet;
+    uint64_t seed;
+    uint8_t quick;
+} params_t;
+
+/** @brief xorshift64* state, one per random stream */
+typedef uint64_t rng_t;
+
+static uint64_t next(rng_t *);
+static uint32_t below(rng_t *, uint32_t);
+static char *make_words(params_t *, uint32_t);
+static void put_word(const char *, uint32_t);
+
+
+/**
+ * @brief Returns the next value of a stream
+ * @param rng       stream to advance
+ * @return uint64_t random value
+ */
+static uint64_t next(rng_t *rng){
+    *rng ^= *rng >> 12;
+    *rng ^= *rng << 25;
+    *rng ^= *rng >> 27;
+    return *rng * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @brief Returns a random number in [0, n)
+ * @param rng       stream to draw from
+ * @param n         upper bound, must be positive
+ * @return uint32_t random number
+ */
+static uint32_t below(rng_t *rng, uint32_t n){
+    return (uint32_t)((next(rng) >> 32) * n >> 32);
+}
+
+/**
+ * @brief Generates n distinct random words, stored back to back
+ *
+ *  Duplicates are rejected through an open addressing table of word indices.
+ *  If the alphabet is too small to get n distinct words the program fails.
+ *
+ * @param p         parameters of the workload
+ * @param n         number of words
+ * @return char*    n rows of wordsize chars
+ */
+static char *make_words(params_t *p, uint32_t n){
+    rng_t rng = p->seed ^ 0x9E3779B97F4A7C15ULL;
+    uint32_t *table, mask = 1, i, j, tries = 0;
+    uint64_t h;
+    char *words = (char *)malloc((size_t)n * p->wordsize), *w;
+
+    while (mask < 2*n) mask <<= 1;
+    table = (uint32_t *)calloc(mask--, sizeof(uint32_t));
+    if (words == NULL || table == NULL) exit(EXIT_FAILURE);
+
+    for (i = 0; i < n; ){
+        w = words + (size_t)i * p->wordsize;
+        for (h = 0, j = 0; j < p->wordsize; ++j){
+            w[j] = symbols[below(&rng, p->alphabet)];
+            h = (h ^ (uint8_t)w[j]) * 0x100000001B3ULL;
+        }
+
+        for (j = h & mask; table[j] != 0; j = (j + 1) & mask){
+            if (memcmp(words + (size_t)(table[j] - 1) * p->wordsize, w, p->wordsize) == 0) break;
+        }
+        if (table[j] == 0) {
+            table[j] = ++i;
+            tries = 0;
+        } else if (++tries > 1000) {
+            fprintf(stderr, "gen: can't find %u distinct words of %u symbols\n", n, p->alphabet);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    free(table);
+    return words;
+}
+
+/**
+ * @brief Writes a word on its own line
+ * @param word      word to write
+ * @param size      length of the word
+ */
+static void put_word(const char *word, uint32_t size){
+    fwrite(word, 1, size, stdout);
+    putchar('\n');
+}
+
+int main(int argc, char *argv[]){
+    params_t p = {5, 10000, 10, 10, 0, 10, 0, 64, 1, 0};
+    rng_t games, guesses;
+    uint32_t g, t, i, n, total, pool;
+    char *words;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "k:n:g:t:i:w:p:a:s:q")) != -1){
+        switch (opt){
+            case 'k': p.wordsize = atoi(optarg); break;
+            case 'n': p.words = atoi(optarg); break;
+            case 'g': p.games = atoi(optarg); break;
+            case 't': p.guesses = atoi(optarg); break;
+            case 'i': p.insert_every = atoi(optarg); break;
+            case 'w': p.insert_words = atoi(optarg); break;
+            case 'p': p.print_every = atoi(optarg); break;
+            case 'a': p.alphabet = atoi(optarg); break;
+            case 's': p.seed = strtoull(optarg, NULL, 10); break;
+            case 'q': p.quick = 1; break;
+            default:
+                fprintf(stderr, "usage: %s [-k wordsize] [-n words] [-g games] [-t guesses] "
+                                "[-i insert_every] [-w insert_words] [-p print_every] "
+                                "[-a alphabet] [-s seed] [-q]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (p.wordsize < 2 || p.wordsize > 255 || p.words == 0 || p.guesses == 0 ||
+        p.alphabet < 2 || p.alphabet > 64 || p.seed == 0
+    ) {
+        fprintf(stderr, "gen: invalid parameters\n");
+        return EXIT_FAILURE;
+    }
+
+    // the words inserted during the games come right after the dictionary
+    pool = (p.insert_every > 0) ? p.games * (p.guesses / p.insert_every + 1) * p.insert_words : 0;
+    words = make_words(&p, p.words + pool);
+    total = p.words;
+    n = total;
+
+    games = p.seed * 3;
+    guesses = p.seed * 5;
+
+    printf("%u\n", p.wordsize);
+    for (i = 0; i < p.words; ++i) put_word(words + (size_t)i * p.wordsize, p.wordsize);
+
+    for (g = 0; g < p.games; ++g){
+        i = below(&games, total);
+        puts("+nuova_partita");
+        put_word(words + (size_t)i * p.wordsize, p.wordsize);
+        printf("%u\n", p.guesses);
+
+        if (p.quick) {
+            put_word(words + (size_t)i * p.wordsize, p.wordsize);
+            continue;
+        }
+
+        for (t = 0; t < p.guesses; ++t){
+            if (p.insert_every > 0 && t % p.insert_every == 0) {
+                puts("+inserisci_inizio");
+                for (i = 0; i < p.insert_words; ++i, ++n) put_word(words + (size_t)n * p.wordsize, p.wordsize);
+                puts("+inserisci_fine");
+            }
+            if (p.print_every > 0 && t % p.print_every == p.print_every - 1) puts("+stampa_filtrate");
+
+            // references and guesses only come from the dictionary, so that they
+            // don't change with the insertions
+            put_word(words + (size_t)below(&guesses, total) * p.wordsize, p.wordsize);
+        }
+    }
+
+    free(words);
+    return EXIT_SUCCESS;
+}
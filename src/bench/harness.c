@@ -0,0 +1,246 @@
+/**
+ * @file harness.c
+ * @author Andrea Sgobbi
+ * @date 17 October 2026
+ * @brief Benchmark harness, times the program on generated workloads
+ *
+ *  The program can't be timed phase by phase from the outside, so the harness
+ *  generates a series of inputs with gen that share the same dictionary and
+ *  the same games, each adding one kind of work to the previous one:
+ *
+ *      load    dictionary and a single game won on the first guess
+ *      reset   every game, all won on the first guess
+ *      guess   every game with all its guesses
+ *      print   as guess, plus a +stampa_filtrate every -p guesses
+ *      insert  as guess, plus an insertion every -i guesses
+ *      full    as guess, with both prints and insertions
+ *
+ *  and the time of a phase is the difference between two of them (print and
+ *  insert are both measured against guess). Every input is run -r times and
+ *  the fastest run is kept, along with the peak RSS of all runs. Results are
+ *  written as JSON:
+ *
+ *      usage: harness [-r runs] [-o file] [-d dir] [gen options] program [args]
+ *
+ *  gen is looked up in the same directory as the harness.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+
+#define SCENARIOS 6
+#define MAX_ARGS 32
+
+/** @brief A generated input and its measurements */
+typedef struct scenario {
+    const char *name;
+    uint8_t quick, single, prints, inserts;
+    double wall;            // seconds, fastest run
+    long rss;               // KiB, peak over all runs
+    uint8_t ok;
+} scenario_t;
+
+static scenario_t scenarios[SCENARIOS] = {
+    {"load",   1, 1, 0, 0, 0, 0, 0},
+    {"reset",  1, 0, 0, 0, 0, 0, 0},
+    {"guess",  0, 0, 0, 0, 0, 0, 0},
+    {"print",  0, 0, 1, 0, 0, 0, 0},
+    {"insert", 0, 0, 0, 1, 0, 0, 0},
+    {"full",   0, 0, 1, 1, 0, 0, 0},
+};
+
+// gen options, stored as they were given
+static const char *gen_opts[] = {"-k", "-n", "-g", "-t", "-i", "-w", "-p", "-a", "-s"};
+static const char *gen_vals[] = {"30", "100000", "50", "10", "5", "10", "5", "64", "1"};
+#define GEN_OPTS (sizeof(gen_opts) / sizeof(gen_opts[0]))
+
+static int spawn(char **, const char *, const char *, struct rusage *);
+static int generate(const char *, scenario_t *, const char *);
+static void measure(scenario_t *, char **, const char *, int);
+static double phase(int, int);
+static void report(FILE *, char **, int);
+
+
+/**
+ * @brief Runs a program with redirected stdin/stdout and waits for it
+ * @param argv      program and arguments, NULL terminated
+ * @param in        file to use as stdin
+ * @param out       file to use as stdout
+ * @param usage     set to the resources used by the program
+ * @return int      exit status of the program, -1 if it didn't exit normally
+ */
+static int spawn(char **argv, const char *in, const char *out, struct rusage *usage){
+    pid_t pid = fork();
+    int status, fd;
+
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        if ((fd = open(in, O_RDONLY)) < 0 || dup2(fd, STDIN_FILENO) < 0) _exit(127);
+        close(fd);
+        if ((fd = open(out, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0 || dup2(fd, STDOUT_FILENO) < 0) _exit(127);
+        close(fd);
+        execv(argv[0], argv);
+        _exit(127);
+    }
+
+    if (wait4(pid, &status, 0, usage) < 0 || !WIFEXITED(status)) return -1;
+    return WEXITSTATUS(status);
+}
+
+/**
+ * @brief Writes the input of a scenario with gen
+ * @param gen       path of the generator
+ * @param s         scenario to generate
+ * @param path      file to write the input to
+ * @return int      0 on success
+ */
+static int generate(const char *gen, scenario_t *s, const char *path){
+    char *argv[MAX_ARGS];
+    struct rusage usage;
+    size_t i;
+    int n = 0;
+
+    argv[n++] = (char *)gen;
+    for (i = 0; i < GEN_OPTS; ++i){
+        if (s->single && strcmp(gen_opts[i], "-g") == 0) continue;
+        if (!(s->prints) && strcmp(gen_opts[i], "-p") == 0) continue;
+        if (!(s->inserts) && strcmp(gen_opts[i], "-i") == 0) continue;
+        argv[n++] = (char *)gen_opts[i];
+        argv[n++] = (char *)gen_vals[i];
+    }
+    if (s->single) {
+        argv[n++] = "-g";
+        argv[n++] = "1";
+    }
+    if (s->quick) argv[n++] = "-q";
+    argv[n] = NULL;
+
+    return spawn(argv, "/dev/null", path, &usage);
+}
+
+/**
+ * @brief Runs the program on the input of a scenario
+ * @param s         scenario to measure
+ * @param argv      program and arguments, NULL terminated
+ * @param path      input file of the scenario
+ * @param runs      number of runs
+ */
+static void measure(scenario_t *s, char **argv, const char *path, int runs){
+    struct timespec start, end;
+    struct rusage usage;
+    double wall;
+    int r;
+
+    s->ok = 1;
+    for (r = 0; r < runs; ++r){
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (spawn(argv, path, "/dev/null", &usage) != 0) {
+            fprintf(stderr, "harness: %s failed on %s\n", argv[0], path);
+            s->ok = 0;
+            return;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        wall = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        if (r == 0 || wall < s->wall) s->wall = wall;
+        if (usage.ru_maxrss > s->rss) s->rss = usage.ru_maxrss;
+    }
+}
+
+/**
+ * @brief Time of a scenario minus the time of the one it builds on
+ * @param s         index of the scenario
+ * @param base      index of the base scenario, -1 for none
+ * @return double   seconds, negative if either run failed
+ */
+static double phase(int s, int base){
+    if (!scenarios[s].ok || (base >= 0 && !scenarios[base].ok)) return -1;
+    return scenarios[s].wall - ((base >= 0) ? scenarios[base].wall : 0);
+}
+
+/**
+ * @brief Writes the results as a JSON object
+ * @param f         file to write to
+ * @param argv      program and arguments, NULL terminated
+ * @param runs      number of runs per scenario
+ */
+static void report(FILE *f, char **argv, int runs){
+    size_t i;
+    int s;
+
+    fprintf(f, "{\n  \"program\": \"%s\",\n  \"args\": [", argv[0]);
+    for (s = 1; argv[s] != NULL; ++s) fprintf(f, "%s\"%s\"", (s > 1) ? ", " : "", argv[s]);
+    fprintf(f, "],\n  \"runs\": %d,\n  \"params\": {", runs);
+    for (i = 0; i < GEN_OPTS; ++i) fprintf(f, "%s\"%c\": %s", (i > 0) ? ", " : "", gen_opts[i][1], gen_vals[i]);
+
+    fprintf(f, "},\n  \"scenarios\": {\n");
+    for (s = 0; s < SCENARIOS; ++s){
+        fprintf(f, "    \"%s\": {\"ok\": %s, \"wall_s\": %.6f, \"max_rss_kib\": %ld}%s\n", scenarios[s].name,
+                scenarios[s].ok ? "true" : "false", scenarios[s].wall, scenarios[s].rss,
+                (s < SCENARIOS - 1) ? "," : "");
+    }
+
+    fprintf(f, "  },\n  \"phases_s\": {\"load\": %.6f, \"reset\": %.6f, \"guess\": %.6f, "
+               "\"print\": %.6f, \"insert\": %.6f, \"total\": %.6f}\n}\n",
+            phase(0, -1), phase(1, 0), phase(2, 1), phase(3, 2), phase(4, 2), phase(5, -1));
+}
+
+int main(int argc, char *argv[]){
+    const char *out = "bench.json", *dir = "bench/work";
+    char gen[4096], path[4096], *slash;
+    FILE *f;
+    size_t i;
+    int opt, runs = 3, s;
+
+    // '+' stops at the program, its own options are passed to it untouched
+    while ((opt = getopt(argc, argv, "+r:o:d:k:n:g:t:i:w:p:a:s:")) != -1){
+        if (opt == 'r') runs = atoi(optarg);
+        else if (opt == 'o') out = optarg;
+        else if (opt == 'd') dir = optarg;
+        else {
+            for (i = 0; i < GEN_OPTS && gen_opts[i][1] != opt; ++i);
+            if (i == GEN_OPTS) {
+                fprintf(stderr, "usage: %s [-r runs] [-o file] [-d dir] [gen options] program [args]\n", argv[0]);
+                return EXIT_FAILURE;
+            }
+            gen_vals[i] = optarg;
+        }
+    }
+    if (optind >= argc || runs < 1) {
+        fprintf(stderr, "usage: %s [-r runs] [-o file] [-d dir] [gen options] program [args]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    // gen sits next to the harness
+    strncpy(gen, argv[0], sizeof(gen) - 8);
+    gen[sizeof(gen) - 8] = '\0';
+    slash = strrchr(gen, '/');
+    strcpy((slash != NULL) ? slash + 1 : gen, "gen");
+    mkdir(dir, 0755);
+
+    for (s = 0; s < SCENARIOS; ++s){
+        snprintf(path, sizeof(path), "%s/%s.txt", dir, scenarios[s].name);
+        if (generate(gen, scenarios + s, path) != 0) {
+            fprintf(stderr, "harness: %s failed for %s\n", gen, scenarios[s].name);
+            return EXIT_FAILURE;
+        }
+        measure(scenarios + s, argv + optind, path, runs);
+        fprintf(stderr, "%-8s %9.3fs %8ld KiB\n", scenarios[s].name, scenarios[s].wall, scenarios[s].rss);
+    }
+
+    if ((f = fopen(out, "w")) == NULL) {
+        perror(out);
+        return EXIT_FAILURE;
+    }
+    report(f, argv + optind, runs);
+    fclose(f);
+
+    return EXIT_SUCCESS;
+}
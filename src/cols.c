@@ -0,0 +1,306 @@
+#include "cols.h"
+#include "output.h"
+#include "stats.h"
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+/** @brief Tests to run on each row, derived from the requirements once per guess */
+typedef struct plan {
+    uint8_t n_pos;
+    uint8_t pos[UINT8_MAX];             // positions whose mask isn't full
+    uint8_t n_let;
+    uint8_t let[CHARSET];               // letters with an occurrence bound
+    uint8_t base[CHARSET];              // occurrences of let[j] fixed by matches
+    uint8_t n_at[CHARSET];
+    uint8_t at[CHARSET][UINT8_MAX];     // positions where let[j] has to be counted
+} plan_t;
+
+static void rebuild(cols_t *, list_t *);
+static void make_plan(plan_t *, req_t *, uint8_t);
+static uint8_t check_row(cols_t *, req_t *, plan_t *, uint32_t);
+static uint32_t filter_rows(cols_t *, req_t *, plan_t *);
+#if defined(__x86_64__)
+static uint32_t filter_avx2(cols_t *, req_t *, plan_t *);
+#endif
+
+#define ALL_LETTERS (~(uint64_t)0)
+#define COLUMN(cols, i) ((cols)->codes + (size_t)(i) * (cols)->cap)
+
+
+/**
+ * @brief Allocates an empty store
+ * @param wordsize  size of the words to store
+ * @return cols_t*  the new store
+ */
+cols_t *cols_init(uint8_t wordsize){
+    cols_t *cols = (cols_t *)calloc(1, sizeof(cols_t));
+
+    if (cols == NULL) exit(EXIT_FAILURE);
+    cols->wordsize = wordsize;
+
+    return cols;
+}
+
+/**
+ * @brief Copies the dictionary of the list in the columns, in order
+ *
+ *  The padding at the end of each column is zeroed, its rows are never live.
+ *
+ * @param cols      store to rebuild
+ * @param list      list holding the dictionary
+ */
+static void rebuild(cols_t *cols, list_t *list){
+    uint32_t r;
+    uint8_t i;
+    const char *word;
+
+    if (list->n_dict > cols->cap){
+        cols->cap = (list->n_dict + list->n_dict / 2 + COLS_BLOCK - 1) & ~(uint32_t)(COLS_BLOCK - 1);
+        free(cols->codes);
+        free(cols->live);
+        cols->codes = (uint8_t *)malloc((size_t)cols->cap * cols->wordsize);
+        cols->live = (uint32_t *)malloc(cols->cap / COLS_BLOCK * sizeof(uint32_t));
+        if (cols->codes == NULL || cols->live == NULL) exit(EXIT_FAILURE);
+    }
+
+    for (r = 0; r < list->n_dict; ++r){
+        word = LIST_WORD(list, list->dict[r]);
+        for (i = 0; i < cols->wordsize; ++i) COLUMN(cols, i)[r] = conversion_table[(int) word[i]];
+    }
+    for (i = 0; i < cols->wordsize; ++i) memset(COLUMN(cols, i) + list->n_dict, 0, cols->cap - list->n_dict);
+
+    cols->n = list->n_dict;
+}
+
+/**
+ * @brief Starts a new game, all the words survive
+ * @param cols      store to reset
+ * @param list      list holding the dictionary
+ */
+void cols_reset(cols_t *cols, list_t *list){
+    uint32_t b;
+
+    if (list->n_dict != cols->n) rebuild(cols, list);
+
+    for (b = 0; b < cols->cap / COLS_BLOCK; ++b) (cols->live)[b] = 0;
+    for (b = 0; b < cols->n / COLS_BLOCK; ++b) (cols->live)[b] = ~(uint32_t)0;
+    if (cols->n % COLS_BLOCK) (cols->live)[b] = ((uint32_t)1 << (cols->n % COLS_BLOCK)) - 1;
+
+    cols->n_live = cols->n;
+    list->n_alive = 0;
+}
+
+/**
+ * @brief Derives the tests each row has to pass from the requirements
+ *
+ *  Positions that allow every letter are skipped. A letter is only counted on
+ *  the positions that allow it besides others: positions that only allow that
+ *  letter add a fixed occurrence, and the ones that don't allow it can only
+ *  hold it in rows that already failed the position test.
+ *
+ * @param plan      plan to fill
+ * @param reqs      requirements struct pointer
+ * @param wordsize  size of the words
+ */
+static void make_plan(plan_t *plan, req_t *reqs, uint8_t wordsize){
+    uint64_t bounds, bit;
+    uint8_t i, j;
+
+    plan->n_pos = 0;
+    for (i = 0; i < wordsize; ++i){
+        if ((reqs->pos)[i] != ALL_LETTERS) (plan->pos)[(plan->n_pos)++] = i;
+    }
+
+    plan->n_let = 0;
+    for (bounds = reqs->known; bounds != 0; bounds &= bounds - 1){
+        j = (plan->n_let)++;
+        (plan->let)[j] = __builtin_ctzll(bounds);
+        bit = BIT((plan->let)[j]);
+
+        (plan->base)[j] = 0;
+        (plan->n_at)[j] = 0;
+        for (i = 0; i < wordsize; ++i){
+            if ((reqs->pos)[i] == bit) ++((plan->base)[j]);
+            else if ((reqs->pos)[i] & bit) (plan->at)[j][((plan->n_at)[j])++] = i;
+        }
+    }
+}
+
+/**
+ * @brief Checks a single row against the plan
+ * @param cols      store holding the row
+ * @param reqs      requirements struct pointer
+ * @param plan      tests derived from reqs
+ * @param r         row to check
+ * @return uint8_t  1 = word is eligible    0 = word is not eligible
+ */
+static uint8_t check_row(cols_t *cols, req_t *reqs, plan_t *plan, uint32_t r){
+    uint8_t i, j, occs, l;
+
+    for (i = 0; i < plan->n_pos; ++i){
+        if (((reqs->pos)[(plan->pos)[i]] & BIT(COLUMN(cols, (plan->pos)[i])[r])) == 0) return 0;
+    }
+
+    for (j = 0; j < plan->n_let; ++j){
+        l = (plan->let)[j];
+        occs = (plan->base)[j];
+        for (i = 0; i < (plan->n_at)[j]; ++i) occs += (COLUMN(cols, (plan->at)[j][i])[r] == l);
+
+        if ((occs < (reqs->count)[l])                                    ||
+            ((reqs->exact & BIT(l)) && occs != (reqs->count)[l])
+        ) return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Filters the live rows one at a time
+ * @param cols      store to filter
+ * @param reqs      requirements struct pointer
+ * @param plan      tests derived from reqs
+ * @return uint32_t number of surviving rows
+ */
+static uint32_t filter_rows(cols_t *cols, req_t *reqs, plan_t *plan){
+    uint32_t b, bits, live, total = 0;
+
+    for (b = 0; b < cols->cap / COLS_BLOCK; ++b){
+        live = (cols->live)[b];
+        for (bits = live; bits != 0; bits &= bits - 1){
+            if (!check_row(cols, reqs, plan, b*COLS_BLOCK + __builtin_ctz(bits))) live &= ~(bits & -bits);
+        }
+        (cols->live)[b] = live;
+        total += __builtin_popcount(live);
+    }
+
+    return total;
+}
+
+#if defined(__x86_64__)
+/**
+ * @brief Filters the live rows 32 at a time with AVX2
+ *
+ *  Position masks are tested with two in-lane shuffles: the mask is split in
+ *  8 bytes and code >> 3 selects the byte, while code & 7 selects the bit from
+ *  a table of powers of two. Matched positions are a single compare. Letter
+ *  occurrences are accumulated by subtracting the compare results (-1 on a
+ *  match) from the fixed count, and compared with the bound once per letter.
+ *
+ * @param cols      store to filter
+ * @param reqs      requirements struct pointer
+ * @param plan      tests derived from reqs
+ * @return uint32_t number of surviving rows
+ */
+__attribute__((target("avx2")))
+static uint32_t filter_avx2(cols_t *cols, req_t *reqs, plan_t *plan){
+    __m256i tables[plan->n_pos + 1], ok, v, idx, bit, cnt, bound;
+    const __m256i low3 = _mm256_set1_epi8(7);
+    const __m256i powers = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0,
+                                            1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+    uint64_t mask;
+    uint32_t b, live, total = 0;
+    size_t off;
+    uint8_t i, j, l;
+
+    for (i = 0; i < plan->n_pos; ++i){
+        mask = (reqs->pos)[(plan->pos)[i]];
+        tables[i] = _mm256_broadcastsi128_si256(_mm_cvtsi64_si128((long long) mask));
+    }
+
+    for (b = 0; b < cols->cap / COLS_BLOCK; ++b){
+        if ((live = (cols->live)[b]) == 0) continue;
+        off = (size_t)b * COLS_BLOCK;
+        ok = _mm256_set1_epi8(-1);
+
+        for (i = 0; i < plan->n_pos; ++i){
+            v = _mm256_loadu_si256((const __m256i *)(COLUMN(cols, (plan->pos)[i]) + off));
+            mask = (reqs->pos)[(plan->pos)[i]];
+
+            if ((mask & (mask - 1)) == 0) {     // matched position
+                ok = _mm256_and_si256(ok, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(__builtin_ctzll(mask))));
+            } else {
+                idx = _mm256_and_si256(_mm256_srli_epi16(v, 3), low3);
+                bit = _mm256_shuffle_epi8(powers, _mm256_and_si256(v, low3));
+                v = _mm256_and_si256(_mm256_shuffle_epi8(tables[i], idx), bit);
+                ok = _mm256_and_si256(ok, _mm256_cmpeq_epi8(v, bit));
+            }
+        }
+        live &= (uint32_t) _mm256_movemask_epi8(ok);
+
+        for (j = 0; j < plan->n_let && live != 0; ++j){
+            l = (plan->let)[j];
+            cnt = _mm256_set1_epi8((plan->base)[j]);
+            for (i = 0; i < (plan->n_at)[j]; ++i){
+                v = _mm256_loadu_si256((const __m256i *)(COLUMN(cols, (plan->at)[j][i]) + off));
+                cnt = _mm256_sub_epi8(cnt, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(l)));
+            }
+
+            bound = _mm256_set1_epi8((reqs->count)[l]);
+            if (reqs->exact & BIT(l)) ok = _mm256_cmpeq_epi8(cnt, bound);
+            else ok = _mm256_cmpeq_epi8(_mm256_max_epu8(cnt, bound), cnt);
+            live &= (uint32_t) _mm256_movemask_epi8(ok);
+        }
+
+        (cols->live)[b] = live;
+        total += __builtin_popcount(live);
+    }
+
+    return total;
+}
+#endif
+
+/**
+ * @brief Removes the rows that don't pass the bounds
+ * @param cols      store to filter
+ * @param reqs      requirements struct pointer
+ * @return uint32_t number of surviving rows
+ */
+uint32_t cols_filter(cols_t *cols, req_t *reqs){
+    plan_t plan;
+
+    STAT(rows_checked, cols->n_live);
+    make_plan(&plan, reqs, cols->wordsize);
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2")) cols->n_live = filter_avx2(cols, reqs, &plan);
+    else
+#endif
+    cols->n_live = filter_rows(cols, reqs, &plan);
+
+    return cols->n_live;
+}
+
+/**
+ * @brief Prints surviving rows and list survivors in order
+ *
+ *  Rows are already sorted, the survivors inserted during the game are merged
+ *  in as they come.
+ *
+ * @param cols      store to print
+ * @param list      list the store was built from
+ */
+void cols_print(cols_t *cols, list_t *list){
+    uint32_t b, bits, j = 0;
+    const char *word;
+
+    for (b = 0; b < cols->cap / COLS_BLOCK; ++b){
+        for (bits = (cols->live)[b]; bits != 0; bits &= bits - 1){
+            word = LIST_WORD(list, (list->dict)[b*COLS_BLOCK + __builtin_ctz(bits)]);
+
+            for (; j < list->n_alive && strcmp(LIST_WORD(list, (list->alive)[j]), word) < 0; ++j){
+                output_line(LIST_WORD(list, (list->alive)[j]), cols->wordsize);
+            }
+            output_line(word, cols->wordsize);
+        }
+    }
+    for (; j < list->n_alive; ++j) output_line(LIST_WORD(list, (list->alive)[j]), cols->wordsize);
+}
+
+/**
+ * @brief Frees the store and all its arrays
+ * @param cols      store to free
+ */
+void cols_free(cols_t *cols){
+    free(cols->codes);
+    free(cols->live);
+    free(cols);
+}
@@ -0,0 +1,95 @@
+/**
+ * @file cols.h
+ * @author Andrea Sgobbi
+ * @date 16 October 2026
+ * @brief Header containing the columnar word store used as a third engine
+ *
+ *  Both the trie and the survivor list check a word one character at a time,
+ *  following a pointer for every word (or every node). With fixed length words
+ *  the dictionary can instead be stored as wordsize columns, where column i
+ *  holds the conversion_table code of the i-th letter of every word, so that a
+ *  constraint can be tested on a whole block of words with vector instructions:
+ *
+ *      - a position mask is looked up for 32 codes at once with two shuffles
+ *        (the byte of the mask holding the bit, and the bit inside the byte)
+ *      - the occurrences of a letter are counted by comparing each column with
+ *        the letter and accumulating the results
+ *
+ *  Rows are kept in the lexicographical order of the dictionary and the
+ *  survivors are a bitset over the rows, so printing them is a plain scan.
+ *  The store is rebuilt from the list at the start of a game whenever words
+ *  were added, while words inserted during a game are left to the survivor
+ *  list (list.h) and merged in when printing.
+ *
+ *  The AVX2 kernel is only used if the CPU supports it, otherwise the same
+ *  tests run one row at a time over the columns.
+ */
+#ifndef COLS_H_
+#define COLS_H_
+#include "game.h"
+#include "list.h"
+
+#define COLS_BLOCK 32   // rows tested together, one bit each in a live word
+
+
+/** @brief Columnar copy of the dictionary with the survivors of the game
+ *
+ *      COLUMNS:
+ *
+ *  - codes:            wordsize columns of cap bytes, column i starts at
+ *                      codes + i*cap. Rows past n are padding
+ *  - live:             bit r of live[r / COLS_BLOCK] is set if row r survived
+ *  - n/cap:            number of rows, and rows allocated (multiple of 32)
+ *  - n_live:           number of bits set in live
+ *
+ *  Row r holds the word with handle dict[r] in the list it was built from.
+ */
+typedef struct cols {
+    uint8_t *codes;
+    uint32_t *live;
+    uint32_t n, cap;
+    uint32_t n_live;
+    uint8_t wordsize;
+} cols_t;
+
+/**
+ * @brief Allocates an empty store                               O(1)
+ * @param wordsize  size of the words to store
+ * @return cols_t*  the new store
+ */
+cols_t *cols_init(uint8_t);
+
+/**
+ * @brief Starts a new game, all the words survive                O(n)
+ *
+ *  Must be called right after list_reset(). The columns are rebuilt if the
+ *  dictionary grew, and the alive array of the list is emptied so that it
+ *  only holds the survivors inserted during the game.
+ *
+ * @param cols      store to reset
+ * @param list      list holding the dictionary
+ */
+void cols_reset(cols_t *, list_t *);
+
+/**
+ * @brief Removes the rows that don't pass the bounds             O(n*k/32)
+ * @param cols      store to filter
+ * @param reqs      requirements struct pointer
+ * @return uint32_t number of surviving rows
+ */
+uint32_t cols_filter(cols_t *, req_t *);
+
+/**
+ * @brief Prints surviving rows and list survivors in order        O(n)
+ * @param cols      store to print
+ * @param list      list the store was built from
+ */
+void cols_print(cols_t *, list_t *);
+
+/**
+ * @brief Frees the store and all its arrays
+ * @param cols      store to free
+ */
+void cols_free(cols_t *);
+
+#endif
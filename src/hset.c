@@ -0,0 +1,151 @@
+#include "hset.h"
+
+static uint64_t hash(const char *, uint8_t);
+static void grow(hset_t *);
+static void copy_image(hset_t *);
+
+#define HSET_SLOTS 1024     // initial number of slots
+#define HSET_ROW(set, slot) LIST_WORD((set)->list, (uint32_t)(slot) - 1)
+#define HSET_TAG(h) ((h) & ~(uint64_t)UINT32_MAX)
+#define HSET_SLOT(set, h) ((uint32_t)((h) >> 32) & (set)->mask)
+
+
+/**
+ * @brief Hashes a word eight characters at a time
+ *
+ *  Each block is mixed in with a multiply by the golden ratio, and the high
+ *  half of the result is folded back so that the next block mixes with all the
+ *  characters before it. Only the high half is used by the table.
+ *
+ * @param word      word to hash
+ * @param len       length of the word
+ * @return uint64_t hash of the word
+ */
+static uint64_t hash(const char *word, uint8_t len){
+    uint64_t h = len, block;
+
+    for (; len >= sizeof(uint64_t); len -= sizeof(uint64_t), word += sizeof(uint64_t)){
+        memcpy(&block, word, sizeof(uint64_t));
+        h = (h ^ block) * 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 32;
+    }
+    if (len > 0){
+        block = 0;
+        memcpy(&block, word, len);
+        h = (h ^ block) * 0x9E3779B97F4A7C15ULL;
+        h ^= h >> 32;
+    }
+
+    return h;
+}
+
+/**
+ * @brief Allocates an empty set over the words of a list
+ * @param list      store the words are added to
+ * @return hset_t*  the new set
+ */
+hset_t *hset_init(list_t *list){
+    hset_t *set = (hset_t *)calloc(1, sizeof(hset_t));
+
+    if (set == NULL) exit(EXIT_FAILURE);
+    set->list = list;
+    set->wordsize = list->wordsize;
+    set->mask = HSET_SLOTS - 1;
+    set->slots = (uint64_t *)calloc(HSET_SLOTS, sizeof(uint64_t));
+    if (set->slots == NULL) exit(EXIT_FAILURE);
+
+    return set;
+}
+
+/**
+ * @brief Doubles the table and moves every slot in the new one
+ *
+ *  Slots are picked from the hash bits stored in the slot itself, so words
+ *  don't have to be read nor hashed again.
+ *
+ * @param set       set to grow
+ */
+static void grow(hset_t *set){
+    uint64_t *old = set->slots;
+    uint32_t n = set->mask + 1, i, j;
+
+    set->mask = 2*set->mask + 1;
+    set->slots = (uint64_t *)calloc((size_t)set->mask + 1, sizeof(uint64_t));
+    if (set->slots == NULL) exit(EXIT_FAILURE);
+
+    for (j = 0; j < n; ++j){
+        if (old[j] == 0) continue;
+        for (i = HSET_SLOT(set, old[j]); set->slots[i] != 0; i = (i + 1) & set->mask);
+        set->slots[i] = old[j];
+    }
+    free(old);
+}
+
+/**
+ * @brief Moves the slots of an image to the heap
+ * @param set       mapped set
+ */
+static void copy_image(hset_t *set){
+    uint64_t *slots = (uint64_t *)malloc(((size_t)set->mask + 1) * sizeof(uint64_t));
+
+    if (slots == NULL) exit(EXIT_FAILURE);
+    memcpy(slots, set->slots, ((size_t)set->mask + 1) * sizeof(uint64_t));
+
+    set->slots = slots;
+    set->mapped = 0;
+}
+
+/**
+ * @brief Adds a word of the list to the set, if it isn't already there
+ *
+ *  A mapped set is copied first, the image itself is never written. If the
+ *  word is already in the set, the slot keeps pointing to its first copy.
+ *
+ * @param set       set to add the word to
+ * @param handle    handle of the word in the list of the set
+ */
+void hset_add(hset_t *set, uint32_t handle){
+    const char *word = LIST_WORD(set->list, handle);
+    uint64_t h = hash(word, set->wordsize);
+    uint32_t i;
+
+    if (set->mapped) copy_image(set);
+
+    for (i = HSET_SLOT(set, h); set->slots[i] != 0; i = (i + 1) & set->mask){
+        if (HSET_TAG(set->slots[i]) == HSET_TAG(h) &&
+            memcmp(HSET_ROW(set, set->slots[i]), word, set->wordsize) == 0
+        ) return;
+    }
+
+    set->slots[i] = HSET_TAG(h) | (handle + 1);
+    ++(set->size);
+
+    if (set->size > set->mask / 2) grow(set);
+}
+
+/**
+ * @brief Checks if a word is in the set
+ * @param set       set to search
+ * @param word      word to look for (wordsize chars)
+ * @return int      1 if found, 0 if not
+ */
+int hset_contains(hset_t *set, const char *word){
+    uint64_t h = hash(word, set->wordsize);
+    uint32_t i;
+
+    for (i = HSET_SLOT(set, h); set->slots[i] != 0; i = (i + 1) & set->mask){
+        if (HSET_TAG(set->slots[i]) == HSET_TAG(h) &&
+            memcmp(HSET_ROW(set, set->slots[i]), word, set->wordsize) == 0
+        ) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Frees the set and its table, the list is left alone
+ * @param set       set to free
+ */
+void hset_free(hset_t *set){
+    if (!set->mapped) free(set->slots);
+    free(set);
+}
@@ -0,0 +1,75 @@
+/**
+ * @file hset.h
+ * @author Andrea Sgobbi
+ * @date 16 October 2026
+ * @brief Header containing the hash set used to validate guesses
+ *
+ *  search() has to go down the trie one level per letter, and every level is a
+ *  different node somewhere in the arena: a guess that isn't in the dictionary
+ *  costs as many cache misses as the length of the prefix it shares with some
+ *  word. The hash set instead indexes the flat store of a survivor list
+ *  (list.h) with an open addressing table with linear probing. Each slot holds
+ *  the handle of the word together with 32 bits of its hash, so a lookup
+ *  usually touches one slot and, only if the hash matches, one row of the
+ *  store. The words themselves are never copied, the set is just the table.
+ *
+ *  Words are only ever added, the table is doubled whenever it's half full.
+ */
+#ifndef HSET_H_
+#define HSET_H_
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "list.h"
+
+
+/** @brief Set of fixed size words
+ *
+ *      HASH SET:
+ *
+ *  - list:             store holding the words of the set
+ *  - size:             number of words in the set
+ *  - slots:            hash table, each slot is (hash >> 32) << 32 | (handle + 1),
+ *                      0 marks an empty slot
+ *  - mask:             number of slots - 1 (the number of slots is a power of 2)
+ *  - mapped:           1 if slots point into a read only image (image.h), they're
+ *                      copied the first time a word is added
+ */
+typedef struct hset {
+    list_t *list;
+    uint32_t size;
+    uint64_t *slots;
+    uint32_t mask;
+    uint8_t wordsize;
+    uint8_t mapped;
+} hset_t;
+
+/**
+ * @brief Allocates an empty set over the words of a list         O(1)
+ * @param list      store the words are added to
+ * @return hset_t*  the new set
+ */
+hset_t *hset_init(list_t *);
+
+/**
+ * @brief Adds a word of the list to the set, if it's not there   O(k)
+ * @param set       set to add the word to
+ * @param handle    handle of the word in the list of the set
+ */
+void hset_add(hset_t *, uint32_t);
+
+/**
+ * @brief Checks if a word is in the set                           O(k)
+ * @param set       set to search
+ * @param word      word to look for (wordsize chars)
+ * @return int      1 if found, 0 if not
+ */
+int hset_contains(hset_t *, const char *);
+
+/**
+ * @brief Frees the set and its table, the list is left alone
+ * @param set       set to free
+ */
+void hset_free(hset_t *);
+
+#endif
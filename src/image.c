@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "image.h"
+
+/** @brief Fixed part at the start of the file, offsets are in bytes */
+typedef struct image_header {
+    char magic[8];
+    uint32_t order;
+    uint32_t wordsize;
+    uint32_t n_words;
+    uint32_t n_set;
+    uint32_t mask;
+    uint32_t unused;
+    uint64_t words;
+    uint64_t dict;
+    uint64_t slots;
+    uint64_t size;
+} image_header_t;
+
+#define ALIGN_UP(x) (((x) + IMAGE_ALIGN - 1) & ~(uint64_t)(IMAGE_ALIGN - 1))
+
+static int write_section(FILE *, const void *, uint64_t, uint64_t *);
+static int in_image(image_header_t *, uint64_t, uint64_t);
+
+
+/**
+ * @brief Writes a section and pads it to the next multiple of IMAGE_ALIGN
+ *
+ *  Empty sections write nothing, their data may be NULL.
+ *
+ * @param f         file to write to
+ * @param data      content of the section
+ * @param len       size of the section
+ * @param off       offset of the section, moved past its padding
+ * @return int      0 on success, -1 on failure
+ */
+static int write_section(FILE *f, const void *data, uint64_t len, uint64_t *off){
+    static const char zeros[IMAGE_ALIGN] = {0};
+    uint64_t pad = ALIGN_UP(*off + len) - (*off + len);
+
+    if (len == 0) return 0;
+    if (fwrite(data, 1, len, f) != len || fwrite(zeros, 1, pad, f) != pad) return -1;
+    *off += len + pad;
+    return 0;
+}
+
+/**
+ * @brief Writes a dictionary to an image file
+ * @param path      file to write, replaced if it exists
+ * @param list      word store of the dictionary, with no pending words
+ * @param set       hash set of the dictionary
+ * @return int      0 on success, -1 with errno set on failure
+ */
+int image_save(const char *path, list_t *list, hset_t *set){
+    image_header_t h;
+    uint64_t off = 0;
+    FILE *f;
+    int res;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, IMAGE_MAGIC, sizeof(h.magic));
+    h.order = IMAGE_ORDER;
+    h.wordsize = list->wordsize;
+    h.n_words = list->size;
+    h.n_set = set->size;
+    h.mask = set->mask;
+
+    h.words = ALIGN_UP(sizeof(h));
+    h.dict = ALIGN_UP(h.words + (uint64_t)h.n_words * (h.wordsize + 1));
+    h.slots = ALIGN_UP(h.dict + (uint64_t)h.n_words * sizeof(uint32_t));
+    h.size = h.slots + ((uint64_t)h.mask + 1) * sizeof(uint64_t);
+
+    if ((f = fopen(path, "wb")) == NULL) return -1;
+    res = write_section(f, &h, sizeof(h), &off)                                              ||
+          write_section(f, list->words, (uint64_t)h.n_words * (h.wordsize + 1), &off)        ||
+          write_section(f, list->dict, (uint64_t)h.n_words * sizeof(uint32_t), &off)         ||
+          fwrite(set->slots, sizeof(uint64_t), (size_t)h.mask + 1, f) != (size_t)h.mask + 1;
+
+    if (fclose(f) != 0 || res) return -1;
+    return 0;
+}
+
+/**
+ * @brief Checks that a section lies inside the image and is aligned
+ * @param h         header of the image
+ * @param off       offset of the section
+ * @param len       size of the section
+ * @return int      1 if the section is valid
+ */
+static int in_image(image_header_t *h, uint64_t off, uint64_t len){
+    return off % IMAGE_ALIGN == 0 && off >= sizeof(image_header_t) && off <= h->size && len <= h->size - off;
+}
+
+/**
+ * @brief Maps an image and builds the list and the set on top of it
+ *
+ *  The header is checked against the size of the file, the contents of the
+ *  sections are trusted. An image of an empty dictionary gives an empty list,
+ *  only the (empty) slots of the set are mapped.
+ *
+ * @param path      image to load
+ * @param list      set to the word store of the dictionary
+ * @param set       set to the hash set of the dictionary
+ * @return int      0 on success, -1 if the image can't be read or is invalid
+ */
+int image_load(const char *path, list_t **list, hset_t **set){
+    image_header_t *h;
+    struct stat st;
+    char *base;
+    list_t *l;
+    hset_t *s;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0) return -1;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(image_header_t)) {
+        close(fd);
+        return -1;
+    }
+    base = (char *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return -1;
+
+    h = (image_header_t *)base;
+    if (memcmp(h->magic, IMAGE_MAGIC, sizeof(h->magic)) != 0 || h->order != IMAGE_ORDER ||
+        h->size != (uint64_t)st.st_size || h->wordsize == 0 || h->wordsize > UINT8_MAX ||
+        ((h->mask + 1) & h->mask) != 0 || h->n_set > h->mask / 2                       ||
+        !in_image(h, h->words, (uint64_t)h->n_words * (h->wordsize + 1))               ||
+        !in_image(h, h->dict, (uint64_t)h->n_words * sizeof(uint32_t))                 ||
+        !in_image(h, h->slots, ((uint64_t)h->mask + 1) * sizeof(uint64_t))
+    ) {
+        munmap(base, st.st_size);
+        return -1;
+    }
+
+    l = list_init(h->wordsize);
+    if (h->n_words > 0) {
+        l->words = base + h->words;
+        l->dict = (uint32_t *)(base + h->dict);
+        l->size = l->cap = l->n_dict = h->n_words;
+        l->alive = (uint32_t *)malloc(l->cap * sizeof(uint32_t));
+        l->tmp = (uint32_t *)malloc(l->cap * sizeof(uint32_t));
+        if (l->alive == NULL || l->tmp == NULL) exit(EXIT_FAILURE);
+        l->mapped = 1;
+    }
+
+    s = hset_init(l);
+    free(s->slots);
+    s->slots = (uint64_t *)(base + h->slots);
+    s->size = h->n_set;
+    s->mask = h->mask;
+    s->mapped = 1;
+
+    *list = l;
+    *set = s;
+    return 0;
+}
@@ -0,0 +1,71 @@
+/**
+ * @file image.h
+ * @author Andrea Sgobbi
+ * @date 17 October 2026
+ * @brief Header containing the prebuilt dictionary images
+ *
+ *  Every start used to parse the whole dictionary, hash every word and sort
+ *  the store before the first game, so for big dictionaries the start of the
+ *  process was mostly the load. An image is the built dictionary written to a
+ *  file, in the layout of ENGINE_LIST: the word store already in order with
+ *  its dictionary order, and the hash set that validates guesses. Loading it
+ *  is a single mmap(), the structures point straight into the mapping and
+ *  pages are only read when they're first touched.
+ *
+ *  The mapping is read only and shared with the page cache, so processes
+ *  started on the same image share its memory. A list or a set copies its
+ *  part of the image to the heap the first time a word is added to it, which
+ *  the server never does (its sessions insert in their own overlay).
+ *
+ *  All the sections are found through offsets from the start of the file, so
+ *  the image works wherever it's mapped. Integers are stored in the byte order
+ *  of the machine that wrote the image, which is checked on load.
+ *
+ *      IMAGE:
+ *
+ *  - header:           IMAGE_MAGIC, IMAGE_ORDER, word size, number of words,
+ *                      number of words and mask of the hash set, offsets of
+ *                      the sections, size of the file
+ *  - words:            rows of the word store (wordsize + 1 chars each)
+ *  - dict:             dictionary order, one uint32_t handle per word
+ *  - slots:            hash table, mask + 1 uint64_t slots holding handles of
+ *                      the word store
+ *
+ *  Every section starts at a multiple of IMAGE_ALIGN.
+ */
+#ifndef IMAGE_H_
+#define IMAGE_H_
+#include <stdint.h>
+#include "list.h"
+#include "hset.h"
+
+#define IMAGE_MAGIC "WRDLIMG2"
+#define IMAGE_ORDER 0x01020304u     // reads differently on the other endianness
+#define IMAGE_ALIGN 64
+
+
+/**
+ * @brief Writes a dictionary to an image file
+ *
+ *  The list must have no words waiting to be merged (list_reset()).
+ *
+ * @param path      file to write, replaced if it exists
+ * @param list      word store of the dictionary
+ * @param set       hash set of the dictionary
+ * @return int      0 on success, -1 with errno set on failure
+ */
+int image_save(const char *, list_t *, hset_t *);
+
+/**
+ * @brief Maps an image and builds the list and the set on top of it
+ *
+ *  The survivor arrays of the list are the only parts on the heap.
+ *
+ * @param path      image to load
+ * @param list      set to the word store of the dictionary
+ * @param set       set to the hash set of the dictionary
+ * @return int      0 on success, -1 if the image can't be read or is invalid
+ */
+int image_load(const char *, list_t **, hset_t **);
+
+#endif
@@ -0,0 +1,138 @@
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "input.h"
+#include "stats.h"
+
+static void fill(input_t *);
+
+
+/**
+ * @brief Prepares the reader for a file descriptor
+ *
+ *  Regular files are mapped whole, starting from the current offset of fd so
+ *  that anything already consumed is skipped. Pipes, terminals and files that
+ *  can't be mapped fall back to reading blocks of INPUT_BLOCK bytes.
+ *
+ * @param in        reader to initialize
+ * @param fd        file descriptor to read from
+ */
+void input_open(input_t *in, int fd){
+    struct stat st;
+    off_t offset;
+
+    memset(in, 0, sizeof(input_t));
+    in->fd = fd;
+
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0){
+        in->buf = (char *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (in->buf != MAP_FAILED){
+            madvise(in->buf, st.st_size, MADV_SEQUENTIAL);
+            offset = lseek(fd, 0, SEEK_CUR);
+
+            in->size = st.st_size;
+            in->pos = (offset > 0 && offset <= st.st_size) ? offset : 0;
+            in->done = in->pos & ~((size_t)sysconf(_SC_PAGESIZE) - 1);
+            in->mapped = 1;
+            in->eof = 1;
+            return;
+        }
+    }
+
+    in->cap = INPUT_BLOCK;
+    in->buf = (char *)malloc(in->cap);
+    if (in->buf == NULL) exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief Reads another block, after the part of the buffer still unread
+ *
+ *  The unread part is first moved to the start of the buffer, which is doubled
+ *  only if a single line doesn't fit in it.
+ *
+ * @param in        reader to fill
+ */
+static void fill(input_t *in){
+    ssize_t r;
+
+    if (in->pos > 0){
+        memmove(in->buf, in->buf + in->pos, in->size - in->pos);
+        in->size -= in->pos;
+        in->pos = 0;
+    }
+    if (in->size == in->cap){
+        in->cap *= 2;
+        in->buf = (char *)realloc(in->buf, in->cap);
+        if (in->buf == NULL) exit(EXIT_FAILURE);
+    }
+
+    do r = read(in->fd, in->buf + in->size, in->cap - in->size);
+    while (r < 0 && errno == EINTR);
+
+    if (r <= 0) in->eof = 1;
+    else in->size += r;
+}
+
+/**
+ * @brief Returns the next line, without its newline
+ *
+ *  The last line of the input is returned even without a trailing newline.
+ *
+ * @param in        reader
+ * @param len       set to the length of the line
+ * @return char*    start of the line, NULL if the input is over
+ */
+char *input_line(input_t *in, size_t *len){
+    size_t scanned = 0, page;
+    char *line, *nl;
+
+    // drop the pages of the mapping that were already read
+    if (in->mapped && in->pos - in->done >= INPUT_BLOCK){
+        page = in->pos & ~((size_t)sysconf(_SC_PAGESIZE) - 1);
+        madvise(in->buf + in->done, page - in->done, MADV_DONTNEED);
+        in->done = page;
+    }
+
+    while (1){
+        line = in->buf + in->pos;
+        nl = (char *)memchr(line + scanned, '\n', in->size - in->pos - scanned);
+
+        if (nl != NULL){
+            *len = nl - line;
+            in->pos += *len + 1;
+            STAT(bytes_read, *len + 1);
+            return line;
+        }
+        if (in->eof) break;
+
+        scanned = in->size - in->pos;   // no need to scan these again
+        fill(in);
+    }
+
+    if (in->pos == in->size) return NULL;
+    *len = in->size - in->pos;
+    in->pos = in->size;
+    STAT(bytes_read, *len);
+
+    return line;
+}
+
+/**
+ * @brief Checks if a whole line is buffered
+ * @param in        reader
+ * @return int      1 if the next line is buffered or the input is over
+ */
+int input_ready(input_t *in){
+    return in->eof || memchr(in->buf + in->pos, '\n', in->size - in->pos) != NULL;
+}
+
+/**
+ * @brief Unmaps or frees the buffer of the reader
+ * @param in        reader to close
+ */
+void input_close(input_t *in){
+    if (in->mapped) munmap(in->buf, in->size);
+    else free(in->buf);
+    in->buf = NULL;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file input.h
+ * @author Andrea Sgobbi
+ * @date 16 October 2026
+ * @brief Header containing the bulk input reader
+ *
+ *  Reading the input through fgets/getchar/scanf costs several locked libc
+ *  calls per word, and skipping the end of command lines depended on the word
+ *  size. The reader instead maps the input when it's a regular file, or reads
+ *  it in large blocks otherwise, and hands out each line as a pointer/length
+ *  view inside its own buffer: nothing is copied and nothing is terminated,
+ *  so lines must be used through their length.
+ *
+ *  A line is only valid until the next call to input_line(), since reading a
+ *  new block can move the buffer around, and mapped pages that have already
+ *  been read are dropped every INPUT_BLOCK bytes so that the input doesn't
+ *  add up to the resident memory. Anything that must outlive a line (like the
+ *  ref string) has to be copied.
+ */
+#ifndef INPUT_H_
+#define INPUT_H_
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define INPUT_BLOCK (1 << 20)   // read size when the input can't be mapped
+
+
+/** @brief Input stream split in lines
+ *
+ *      INPUT:
+ *
+ *  - buf:              whole mapped file, or buffer holding the current block
+ *  - size:             number of valid bytes in buf
+ *  - pos:              start of the next line in buf
+ *  - done:             mapped bytes before this offset have been dropped
+ *  - cap:              size of the allocation when reading in blocks
+ *  - fd:               file descriptor the input comes from
+ *  - mapped:           1 if buf is a read only mapping of the file
+ *  - eof:              1 once read() has returned 0
+ */
+typedef struct input {
+    char *buf;
+    size_t size;
+    size_t pos;
+    size_t done;
+    size_t cap;
+    int fd;
+    uint8_t mapped;
+    uint8_t eof;
+} input_t;
+
+/**
+ * @brief Prepares the reader for a file descriptor               O(1)
+ * @param in        reader to initialize
+ * @param fd        file descriptor to read from
+ */
+void input_open(input_t *, int);
+
+/**
+ * @brief Returns the next line, without its newline              O(len)
+ * @param in        reader
+ * @param len       set to the length of the line
+ * @return char*    start of the line, NULL if the input is over
+ */
+char *input_line(input_t *, size_t *);
+
+/**
+ * @brief Checks if a whole line is buffered                      O(len)
+ *
+ *  When it is, input_line() returns it without blocking on a read().
+ *
+ * @param in        reader
+ * @return int      1 if the next line is buffered or the input is over
+ */
+int input_ready(input_t *);
+
+/**
+ * @brief Unmaps or frees the buffer of the reader
+ * @param in        reader to close
+ */
+void input_close(input_t *);
+
+#endif
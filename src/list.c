@@ -0,0 +1,244 @@
+#include "list.h"
+#include "trie.h"
+#include "output.h"
+
+static void sort_small(list_t *, uint32_t *, uint32_t, uint8_t);
+static void radix_sort(list_t *, uint32_t *, uint32_t *, uint32_t, uint8_t);
+static void sort_handles(list_t *, uint32_t *, uint32_t);
+static uint32_t merge(list_t *, uint32_t *, uint32_t, uint32_t *, uint32_t, uint32_t *);
+static void copy_image(list_t *);
+
+#define RADIX_MIN 32    // ranges with fewer words are insertion sorted
+
+// bucket of a char, anything outside the alphabet goes in an extra last bucket
+#define SYMBOL(c) (((unsigned char)(c) < 128) ? conversion_table[(int) (c)] : CHARSET)
+
+
+/**
+ * @brief Insertion sort for the small ranges left by radix_sort()
+ * @param list      list the handles belong to
+ * @param handles   array of handles
+ * @param n         number of handles
+ * @param depth     letters the words already share
+ */
+static void sort_small(list_t *list, uint32_t *handles, uint32_t n, uint8_t depth){
+    uint32_t i, j, h;
+
+    for (i = 1; i < n; ++i){
+        h = handles[i];
+        for (j = i; j > 0 && strcmp(LIST_WORD(list, handles[j - 1]) + depth, LIST_WORD(list, h) + depth) > 0; --j){
+            handles[j] = handles[j - 1];
+        }
+        handles[j] = h;
+    }
+}
+
+/**
+ * @brief Most significant digit first radix sort on the 64 letters
+ *
+ *  The handles are distributed by their letter at depth through tmp, and each
+ *  bucket is then sorted on the next letter. conversion_table follows the
+ *  ASCII order, so this is the same order as strcmp(). Words with chars out
+ *  of the alphabet (only from a server client) end up in the extra bucket,
+ *  which keeps the arrays in bounds but not those words in order.
+ *
+ * @param list      list the handles belong to
+ * @param handles   array of handles
+ * @param tmp       scratch array of at least n handles
+ * @param n         number of handles
+ * @param depth     letters the words already share
+ */
+static void radix_sort(list_t *list, uint32_t *handles, uint32_t *tmp, uint32_t n, uint8_t depth){
+    uint32_t start[CHARSET + 2] = {0}, next[CHARSET + 1], i;
+    uint8_t c;
+
+    if (n < RADIX_MIN) {
+        sort_small(list, handles, n, depth);
+        return;
+    }
+    if (depth == list->wordsize) return;
+
+    for (i = 0; i < n; ++i) ++(start[SYMBOL(LIST_WORD(list, handles[i])[depth]) + 1]);
+    for (c = 0; c <= CHARSET; ++c){
+        start[c + 1] += start[c];
+        next[c] = start[c];
+    }
+    for (i = 0; i < n; ++i) tmp[next[SYMBOL(LIST_WORD(list, handles[i])[depth])]++] = handles[i];
+    memcpy(handles, tmp, n * sizeof(uint32_t));
+
+    for (c = 0; c <= CHARSET; ++c){
+        if (start[c + 1] - start[c] > 1) radix_sort(list, handles + start[c], tmp, start[c + 1] - start[c], depth + 1);
+    }
+}
+
+/**
+ * @brief Sorts handles by their words, from a letter onwards
+ * @param list      list the handles belong to
+ * @param handles   array of handles
+ * @param tmp       scratch array of at least n handles
+ * @param n         number of handles
+ * @param depth     letters the words already share
+ */
+void list_sort(list_t *list, uint32_t *handles, uint32_t *tmp, uint32_t n, uint8_t depth){
+    radix_sort(list, handles, tmp, n, depth);
+}
+
+/**
+ * @brief Sorts an array of handles by the words they refer to
+ *
+ *  The tmp array of the list is used as scratch, so it must not be in use.
+ *
+ * @param list      list the handles belong to
+ * @param handles   array of handles
+ * @param n         number of handles
+ */
+static void sort_handles(list_t *list, uint32_t *handles, uint32_t n){
+    radix_sort(list, handles, list->tmp, n, 0);
+}
+
+/**
+ * @brief Merges two sorted arrays of handles into dst
+ * @param list      list the handles belong to
+ * @param a         first sorted array
+ * @param n_a       size of a
+ * @param b         second sorted array
+ * @param n_b       size of b
+ * @param dst       destination, can't overlap a or b
+ * @return uint32_t size of the merged array
+ */
+static uint32_t merge(list_t *list, uint32_t *a, uint32_t n_a, uint32_t *b, uint32_t n_b, uint32_t *dst){
+    uint32_t i = 0, j = 0, n = 0;
+
+    while (i < n_a && j < n_b){
+        if (strcmp(LIST_WORD(list, a[i]), LIST_WORD(list, b[j])) < 0) dst[n++] = a[i++];
+        else dst[n++] = b[j++];
+    }
+    while (i < n_a) dst[n++] = a[i++];
+    while (j < n_b) dst[n++] = b[j++];
+
+    return n;
+}
+
+/**
+ * @brief Allocates an empty list
+ * @param wordsize  size of the words to store
+ * @return list_t*  the new list
+ */
+list_t *list_init(uint8_t wordsize){
+    list_t *list = (list_t *)calloc(1, sizeof(list_t));
+
+    if (list == NULL) exit(EXIT_FAILURE);
+    list->wordsize = wordsize;
+    return list;
+}
+
+/**
+ * @brief Moves the words and the dictionary order of an image to the heap
+ * @param list      mapped list, with a capacity equal to its size
+ */
+static void copy_image(list_t *list){
+    char *words = (char *)malloc((size_t)list->cap * (list->wordsize + 1));
+    uint32_t *dict = (uint32_t *)malloc(list->cap * sizeof(uint32_t));
+
+    if (words == NULL || dict == NULL) exit(EXIT_FAILURE);
+    memcpy(words, list->words, (size_t)list->size * (list->wordsize + 1));
+    memcpy(dict, list->dict, list->n_dict * sizeof(uint32_t));
+
+    list->words = words;
+    list->dict = dict;
+    list->mapped = 0;
+}
+
+/**
+ * @brief Appends a word to the store
+ *
+ *  All arrays share the capacity of the store and are doubled together. A
+ *  mapped store is copied first, the image itself is never written.
+ *
+ * @param list      list to add the word to
+ * @param word      word to add
+ * @return uint32_t handle of the word
+ */
+uint32_t list_add(list_t *list, const char *word){
+
+    if (list->mapped) copy_image(list);
+    if (list->size == list->cap){
+        list->cap = (list->cap == 0) ? 1024 : 2*list->cap;
+        list->words = (char *)realloc(list->words, (size_t)list->cap * (list->wordsize + 1));
+        list->dict  = (uint32_t *)realloc(list->dict, list->cap * sizeof(uint32_t));
+        list->alive = (uint32_t *)realloc(list->alive, list->cap * sizeof(uint32_t));
+        list->tmp   = (uint32_t *)realloc(list->tmp, list->cap * sizeof(uint32_t));
+        if (list->words == NULL || list->dict == NULL || list->alive == NULL || list->tmp == NULL) exit(EXIT_FAILURE);
+    }
+
+    memcpy(LIST_WORD(list, list->size), word, list->wordsize);
+    LIST_WORD(list, list->size)[list->wordsize] = '\0';
+
+    return (list->size)++;
+}
+
+/**
+ * @brief Merges pending words in the dictionary, all words survive
+ *
+ *  Pending words are sorted on their own and then merged with the dictionary,
+ *  so the whole store only gets sorted once, on the first game.
+ *
+ * @param list      list to reset for a new game
+ */
+void list_reset(list_t *list){
+    uint32_t h, n = list->size - list->n_dict, *tmp;
+
+    if (n > 0){
+        for (h = list->n_dict; h < list->size; ++h) list->alive[h - list->n_dict] = h;
+        sort_handles(list, list->alive, n);
+
+        list->n_dict = merge(list, list->dict, list->n_dict, list->alive, n, list->tmp);
+        tmp = list->dict;
+        list->dict = list->tmp;
+        list->tmp = tmp;
+    }
+
+    if (list->n_dict > 0) memcpy(list->alive, list->dict, list->n_dict * sizeof(uint32_t));
+    list->n_alive = list->n_dict;
+}
+
+/**
+ * @brief Merges new survivors in the alive array
+ * @param list      list to merge the words in
+ * @param n         number of new survivors, stored after the current ones
+ */
+void list_merge_alive(list_t *list, uint32_t n){
+    uint32_t *handles = list->alive + list->n_alive, *tmp;
+
+    if (n == 0) return;
+    sort_handles(list, handles, n);
+
+    list->n_alive = merge(list, list->alive, list->n_alive, handles, n, list->tmp);
+    tmp = list->alive;
+    list->alive = list->tmp;
+    list->tmp = tmp;
+}
+
+/**
+ * @brief Prints the survivors in lexicographical order
+ * @param list      list to print
+ */
+void list_print(list_t *list){
+    uint32_t i;
+
+    for (i = 0; i < list->n_alive; ++i) output_line(LIST_WORD(list, list->alive[i]), list->wordsize);
+}
+
+/**
+ * @brief Frees the list and all its arrays
+ * @param list      list to free
+ */
+void list_free(list_t *list){
+    if (!list->mapped) {
+        free(list->words);
+        free(list->dict);
+    }
+    free(list->alive);
+    free(list->tmp);
+    free(list);
+}
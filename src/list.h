@@ -0,0 +1,121 @@
+/**
+ * @file list.h
+ * @author Andrea Sgobbi
+ * @date 16 October 2026
+ * @brief Header containing the survivor list used as an alternative filter
+ *
+ *  prune_trie() has to walk every non pruned sibling list on each guess, so
+ *  late in a game, when only a handful of words are left, most of the time is
+ *  spent chasing pointers to reach them. The survivor list instead keeps every
+ *  word in a flat store and the candidates of the current game as an ordered
+ *  array of handles (indices in the store), which is compacted in place after
+ *  each guess: the cost of a guess only depends on how many words survived.
+ *
+ *  The trie isn't built at all with this engine, guesses are validated through
+ *  a hash set (hset.h) instead.
+ */
+#ifndef LIST_H_
+#define LIST_H_
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+
+/** @brief Word store with the dictionary order and the current survivors
+ *
+ *      LIST:
+ *
+ *  - words:            every word in insertion order, each one in a row of
+ *                      wordsize + 1 chars with a terminating null character.
+ *                      A word is identified by its row index (handle)
+ *  - size/cap:         number of stored words and rows allocated
+ *  - dict:             handles of the first n_dict words in lexicographical
+ *                      order. Since handles are given out in order, the words
+ *                      in [n_dict, size) are the ones waiting to be merged in
+ *  - alive:            handles of the words still compatible with the current
+ *                      game, in lexicographical order
+ *  - tmp:              scratch array for merges, same capacity as the store
+ *  - mapped:           1 if words and dict point into a read only image
+ *                      (image.h), they're copied the first time a word is added
+ */
+typedef struct list {
+    char *words;
+    uint32_t size, cap;
+    uint8_t wordsize;
+
+    uint32_t *dict;
+    uint32_t n_dict;
+
+    uint32_t *alive;
+    uint32_t n_alive;
+
+    uint32_t *tmp;
+    uint8_t mapped;
+} list_t;
+
+#define LIST_WORD(list, h) ((list)->words + (size_t)(h) * ((list)->wordsize + 1))
+
+/**
+ * @brief Allocates an empty list                                O(1)
+ * @param wordsize  size of the words to store
+ * @return list_t*  the new list
+ */
+list_t *list_init(uint8_t);
+
+/**
+ * @brief Appends a word to the store                            O(k)
+ *
+ *  The word is not part of the dictionary order nor of the survivors until
+ *  list_reset() or list_merge_alive() are called.
+ *
+ * @param list      list to add the word to
+ * @param word      word to add
+ * @return uint32_t handle of the word
+ */
+uint32_t list_add(list_t *, const char *);
+
+/**
+ * @brief Merges pending words in the dictionary, all words survive O(n)
+ * @param list      list to reset for a new game
+ */
+void list_reset(list_t *);
+
+/**
+ * @brief Sorts handles by their words, from a letter onwards     O(nk)
+ *
+ *  Only handles and tmp are written, so disjoint ranges of the same list can
+ *  be sorted by different threads at the same time.
+ *
+ * @param list      list the handles belong to
+ * @param handles   array of handles
+ * @param tmp       scratch array of at least n handles
+ * @param n         number of handles
+ * @param depth     letters the words already share
+ */
+void list_sort(list_t *, uint32_t *, uint32_t *, uint32_t, uint8_t);
+
+/**
+ * @brief Merges new survivors in the alive array       O(m log(m) + n)
+ *
+ *  The handles of the new survivors must be appended, in any order, right
+ *  after the current ones (alive[n_alive] onwards).
+ *
+ * @param list      list to merge the words in
+ * @param n         number of new survivors
+ */
+void list_merge_alive(list_t *, uint32_t);
+
+/**
+ * @brief Prints the survivors in lexicographical order           O(n)
+ * @param list      list to print
+ */
+void list_print(list_t *);
+
+/**
+ * @brief Frees the list and all its arrays
+ * @param list      list to free
+ */
+void list_free(list_t *);
+
+#endif
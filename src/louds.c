@@ -0,0 +1,447 @@
+#include "louds.h"
+#include "output.h"
+#include "stats.h"
+
+/** @brief Node waiting to be encoded, with the range of its words */
+typedef struct pending {
+    uint32_t lo, hi;
+    uint8_t depth;      // letters of the words already consumed
+} pending_t;
+
+#define WORDS(bits) (((size_t)(bits) + 63) / 64)
+#define GET_BIT(v, i) (((v)[(i) >> 6] >> ((i) & 63)) & 1)
+#define SET_BIT(v, i) ((v)[(i) >> 6] |= BIT((i) & 63))
+
+static uint64_t select0(louds_t *, uint32_t);
+static uint64_t next_zero(louds_t *, uint64_t);
+static char *suffix(louds_t *, uint32_t, uint8_t);
+static void release(louds_t *);
+static void index_bits(louds_t *, uint64_t);
+static void build(louds_t *, const char **, uint32_t);
+static void extract(louds_t *, uint32_t, uint32_t, uint64_t, char *, uint8_t, char **);
+static uint32_t filter_family(louds_t *, uint32_t, uint32_t, uint64_t, req_t *, uint8_t *, uint8_t);
+static void print_family(louds_t *, uint32_t, uint32_t, uint64_t, char *, uint8_t, list_t *, uint32_t *);
+
+
+/**
+ * @brief Position of a zero in the LOUDS bitvector
+ *
+ *  Starts from the word holding the closest sampled zero, moves to the word
+ *  holding the zero through the rank directory, and clears the zeros before it
+ *  in that word.
+ *
+ * @param louds     trie
+ * @param i         index of the zero (the one closing node i)
+ * @return uint64_t position of the zero
+ */
+static uint64_t select0(louds_t *louds, uint32_t i){
+    uint32_t w = (louds->zsample)[i / 64], r;
+    uint64_t x;
+
+    while ((louds->zrank)[w + 1] <= i) ++w;
+    x = ~(louds->bits)[w];
+    for (r = i - (louds->zrank)[w]; r > 0; --r) x &= x - 1;
+
+    return (uint64_t)w * 64 + __builtin_ctzll(x);
+}
+
+/**
+ * @brief Position of the first zero at or after p
+ *
+ *  A node has at most 64 children, so this never looks past two words.
+ *
+ * @param louds     trie
+ * @param p         position to start from
+ * @return uint64_t position of the zero
+ */
+static uint64_t next_zero(louds_t *louds, uint64_t p){
+    uint64_t w = p >> 6, x = ~(louds->bits)[w] & (~(uint64_t)0 << (p & 63));
+
+    while (x == 0) x = ~(louds->bits)[++w];
+    return w * 64 + __builtin_ctzll(x);
+}
+
+/**
+ * @brief Suffix of a leaf
+ * @param louds     trie
+ * @param i         leaf node
+ * @param p         position of the letter of the leaf
+ * @return char*    null terminated suffix, wordsize - p - 1 chars
+ */
+static char *suffix(louds_t *louds, uint32_t i, uint8_t p){
+    uint32_t leaf = (louds->lrank)[i >> 6] + __builtin_popcountll((louds->leaves)[i >> 6] & (BIT(i & 63) - 1));
+
+    return louds->suffixes + (louds->lvl_off)[p] + (size_t)(leaf - (louds->lvl_leaf)[p]) * (louds->wordsize - p);
+}
+
+/**
+ * @brief Frees the arrays of the encoding
+ * @param louds     trie
+ */
+static void release(louds_t *louds){
+    free(louds->bits);
+    free(louds->zrank);
+    free(louds->zsample);
+    free(louds->labels);
+    free(louds->leaves);
+    free(louds->lrank);
+    free(louds->suffixes);
+    free(louds->lvl_leaf);
+    free(louds->lvl_off);
+    free(louds->dead);
+}
+
+/**
+ * @brief Builds the rank directories and the zero samples
+ * @param louds     trie with bits, leaves and n_nodes set
+ * @param n_bits    length of the LOUDS bitvector
+ */
+static void index_bits(louds_t *louds, uint64_t n_bits){
+    size_t n_w = WORDS(n_bits), n_l = WORDS(louds->n_nodes), w;
+    uint32_t j;
+
+    louds->zrank = (uint32_t *)malloc((n_w + 1) * sizeof(uint32_t));
+    louds->zsample = (uint32_t *)malloc((louds->n_nodes / 64 + 1) * sizeof(uint32_t));
+    louds->lrank = (uint32_t *)malloc(n_l * sizeof(uint32_t));
+    louds->dead = (uint64_t *)calloc(n_l, sizeof(uint64_t));
+    if (louds->zrank == NULL || louds->zsample == NULL || louds->lrank == NULL || louds->dead == NULL) exit(EXIT_FAILURE);
+
+    (louds->zrank)[0] = 0;
+    for (w = 0; w < n_w; ++w){
+        (louds->zrank)[w + 1] = (louds->zrank)[w] + 64 - __builtin_popcountll((louds->bits)[w]);
+        for (j = ((louds->zrank)[w] + 63) / 64; 64*j < (louds->zrank)[w + 1] && j <= louds->n_nodes / 64; ++j){
+            (louds->zsample)[j] = w;
+        }
+    }
+
+    for (w = 0, j = 0; w < n_l; ++w){
+        (louds->lrank)[w] = j;
+        j += __builtin_popcountll((louds->leaves)[w]);
+    }
+}
+
+/**
+ * @brief Encodes a sorted array of words
+ *
+ *  Nodes are encoded in level order through a queue of word ranges: a range
+ *  with a single word becomes a leaf, any other is split by the letter at its
+ *  depth, one child per letter. The queue is also the node numbering, so
+ *  labels and bits are written as the nodes are created.
+ *
+ * @param louds     trie to encode the words in, the old encoding is dropped
+ * @param words     n words of wordsize chars in lexicographical order
+ * @param n         number of words
+ */
+static void build(louds_t *louds, const char **words, uint32_t n){
+    uint8_t k = louds->wordsize, d, last = UINT8_MAX;
+    uint32_t cap = n + n/4 + 1024, i, lo, hi, e, n_leaves = 0;
+    uint64_t pos = 0;
+    size_t off = 0;
+    pending_t *queue = (pending_t *)malloc(cap * sizeof(pending_t));
+
+    release(louds);
+    louds->labels = (uint8_t *)malloc(cap);
+    louds->bits = (uint64_t *)calloc(WORDS(2*(size_t)cap) + 1, sizeof(uint64_t));
+    louds->leaves = (uint64_t *)calloc(WORDS(cap), sizeof(uint64_t));
+    louds->suffixes = (char *)malloc((size_t)n * k + 1);
+    louds->lvl_leaf = (uint32_t *)calloc(k, sizeof(uint32_t));
+    louds->lvl_off = (size_t *)calloc(k, sizeof(size_t));
+    if (queue == NULL || louds->labels == NULL || louds->bits == NULL || louds->leaves == NULL ||
+        louds->suffixes == NULL || louds->lvl_leaf == NULL || louds->lvl_off == NULL
+    ) exit(EXIT_FAILURE);
+
+    queue[0].lo = 0;
+    queue[0].hi = n;
+    queue[0].depth = 0;
+    louds->n_nodes = 1;
+
+    for (i = 0; i < louds->n_nodes; ++i, ++pos){
+        lo = queue[i].lo;
+        hi = queue[i].hi;
+        d = queue[i].depth;
+
+        // a single word left, the rest of it is the suffix (leaves come level by level)
+        if (i > 0 && (hi - lo == 1 || d == k)) {
+            if (d - 1 != last) {
+                last = d - 1;
+                (louds->lvl_leaf)[last] = n_leaves;
+                (louds->lvl_off)[last] = off;
+            }
+            SET_BIT(louds->leaves, i);
+            memcpy(louds->suffixes + off, words[lo] + d, k - d);
+            (louds->suffixes)[off + k - d] = '\0';
+            off += k - d + 1;
+            ++n_leaves;
+            continue;
+        }
+
+        for (; lo < hi; lo = e, ++pos){
+            for (e = lo + 1; e < hi && words[e][d] == words[lo][d]; ++e);
+
+            if (louds->n_nodes == cap) {
+                cap *= 2;
+                queue = (pending_t *)realloc(queue, cap * sizeof(pending_t));
+                louds->labels = (uint8_t *)realloc(louds->labels, cap);
+                louds->bits = (uint64_t *)realloc(louds->bits, (WORDS(2*(size_t)cap) + 1) * sizeof(uint64_t));
+                louds->leaves = (uint64_t *)realloc(louds->leaves, WORDS(cap) * sizeof(uint64_t));
+                if (queue == NULL || louds->labels == NULL || louds->bits == NULL || louds->leaves == NULL) exit(EXIT_FAILURE);
+                memset(louds->bits + WORDS(cap) + 1, 0, (WORDS(2*(size_t)cap) - WORDS(cap)) * sizeof(uint64_t));
+                memset(louds->leaves + WORDS(cap/2), 0, (WORDS(cap) - WORDS(cap/2)) * sizeof(uint64_t));
+            }
+
+            queue[louds->n_nodes].lo = lo;
+            queue[louds->n_nodes].hi = e;
+            queue[louds->n_nodes].depth = d + 1;
+            (louds->labels)[louds->n_nodes] = words[lo][d];
+            ++(louds->n_nodes);
+            SET_BIT(louds->bits, pos);
+        }
+    }
+    free(queue);
+
+    louds->suffixes = (char *)realloc(louds->suffixes, off + 1);
+    louds->labels = (uint8_t *)realloc(louds->labels, louds->n_nodes);
+    louds->n_words = n_leaves;
+    index_bits(louds, pos);
+}
+
+/**
+ * @brief Writes the words beneath a family of nodes in order
+ * @param louds     trie
+ * @param c         first node of the family
+ * @param n         number of nodes in the family
+ * @param p         position of the block of the first node in bits
+ * @param prefix    letters leading to the family
+ * @param depth     position of the letters of the family
+ * @param dst       where to write the words, moved past them
+ */
+static void extract(louds_t *louds, uint32_t c, uint32_t n, uint64_t p, char *prefix, uint8_t depth, char **dst){
+    uint32_t i;
+    uint64_t q;
+
+    for (i = c; i < c + n; ++i, p = q + 1){
+        q = next_zero(louds, p);
+        prefix[depth] = (louds->labels)[i];
+
+        if (q == p) {
+            memcpy(*dst, prefix, depth + 1);
+            memcpy(*dst + depth + 1, suffix(louds, i, depth), louds->wordsize - depth - 1);
+            *dst += louds->wordsize;
+        } else {
+            extract(louds, p - i + 1, q - p, select0(louds, p - i) + 1, prefix, depth + 1, dst);
+        }
+    }
+}
+
+/**
+ * @brief Allocates an empty trie
+ * @param wordsize  size of the words to store
+ * @return louds_t* the new trie
+ */
+louds_t *louds_init(uint8_t wordsize){
+    louds_t *louds = (louds_t *)calloc(1, sizeof(louds_t));
+
+    if (louds == NULL) exit(EXIT_FAILURE);
+    louds->wordsize = wordsize;
+    build(louds, NULL, 0);
+
+    return louds;
+}
+
+/**
+ * @brief Starts a new game, all the words survive
+ *
+ *  Encoding again takes the encoded words out in order and merges them with
+ *  the words of the list, which are already sorted by list_reset(). Only the
+ *  encoded words are copied, the list ones are used where they are.
+ *
+ * @param louds     trie to reset
+ * @param list      words inserted since the last build
+ * @return int      1 if the words of the list were encoded, 0 if not
+ */
+int louds_reset(louds_t *louds, list_t *list){
+    uint8_t k = louds->wordsize;
+    uint32_t n = louds->n_words, i = 0, j = 0, m = 0, q0;
+    char prefix[k], *old, *dst;
+    const char **words;
+    int rebuilt = 0;
+
+    if (list->n_dict > 0 && (n == 0 || list->n_dict > n / LOUDS_DELTA)) {
+        old = dst = (char *)malloc((size_t)n * k + 1);
+        words = (const char **)malloc(((size_t)n + list->n_dict) * sizeof(char *));
+        if (old == NULL || words == NULL) exit(EXIT_FAILURE);
+
+        q0 = next_zero(louds, 0);
+        extract(louds, 1, q0, q0 + 1, prefix, 0, &dst);
+
+        while (i < n || j < list->n_dict){
+            if (j == list->n_dict || (i < n && memcmp(old + (size_t)i * k, LIST_WORD(list, (list->dict)[j]), k) < 0)) {
+                words[m++] = old + (size_t)(i++) * k;
+            } else {
+                words[m++] = LIST_WORD(list, (list->dict)[j++]);
+            }
+        }
+        build(louds, words, m);
+
+        free(old);
+        free(words);
+        rebuilt = 1;
+    }
+
+    memset(louds->dead, 0, WORDS(louds->n_nodes) * sizeof(uint64_t));
+    louds->n_live = louds->n_words;
+    return rebuilt;
+}
+
+/**
+ * @brief Checks if a word is encoded in the trie
+ *
+ *  Goes down one level per letter, looking for the letter among the labels of
+ *  the children, until a leaf is reached and its suffix is compared.
+ *
+ * @param louds     trie to search
+ * @param word      word to look for (wordsize chars)
+ * @return int      1 if found, 0 if not
+ */
+int louds_search(louds_t *louds, const char *word){
+    uint32_t i = 0, x, end;
+    uint64_t p = 0, q;
+    uint8_t d = 0;
+
+    while (1){
+        q = next_zero(louds, p);
+        if (q == p) return i > 0 && memcmp(suffix(louds, i, d - 1), word + d, louds->wordsize - d) == 0;
+
+        end = p - i + 1 + (q - p);
+        for (x = p - i + 1; x < end && (louds->labels)[x] != (uint8_t)word[d]; ++x);
+        if (x == end) return 0;
+
+        p = select0(louds, x - 1) + 1;
+        i = x;
+        ++d;
+    }
+}
+
+/**
+ * @brief Prunes a family of nodes and the subtrees beneath them
+ *
+ *  Same tests as prune_child(): the letter of a node must be allowed in its
+ *  position and not exceed an exact bound, leaves are checked by check_leaf()
+ *  and branches without valid words beneath them are pruned too. Words never
+ *  come back during a game (inserted ones go to the list), so pruned nodes are
+ *  skipped until the next reset.
+ *
+ * @param louds     trie to filter
+ * @param c         first node of the family
+ * @param n         number of nodes in the family
+ * @param p         position of the block of the first node in bits
+ * @param reqs      requirements struct pointer
+ * @param hist      letter histogram of the prefix leading to the family
+ * @param depth     position of the letters of the family
+ * @return uint32_t number of words beneath the family that pass the bounds
+ */
+static uint32_t filter_family(louds_t *louds, uint32_t c, uint32_t n, uint64_t p, req_t *reqs, uint8_t *hist, uint8_t depth){
+    uint32_t i, r, res = 0;
+    uint8_t index;
+    uint64_t q;
+
+    for (i = c; i < c + n; ++i, p = q + 1){
+        q = next_zero(louds, p);
+        if (GET_BIT(louds->dead, i)) continue;
+
+        STAT(nodes_visited, 1);
+        index = conversion_table[(int) (louds->labels)[i]];
+
+        // prune if incorrect position or no occurrences left
+        if ((((reqs->pos)[depth] & BIT(index)) == 0)                             ||
+            ((reqs->exact & BIT(index)) && hist[index] >= (reqs->count)[index])
+        ) {
+            STAT(nodes_pruned, 1);
+            SET_BIT(louds->dead, i);
+            continue;
+        }
+
+        ++(hist[index]);
+        if (q == p) r = check_leaf(suffix(louds, i, depth), reqs, hist, depth + 1);
+        else r = filter_family(louds, p - i + 1, q - p, select0(louds, p - i) + 1, reqs, hist, depth + 1);
+        --(hist[index]);
+
+        if (r == 0) SET_BIT(louds->dead, i);
+        res += r;
+    }
+
+    return res;
+}
+
+/**
+ * @brief Prunes the words that don't pass the bounds
+ * @param louds     trie to filter
+ * @param reqs      requirements struct pointer
+ * @return uint32_t number of surviving encoded words
+ */
+uint32_t louds_filter(louds_t *louds, req_t *reqs){
+    uint8_t hist[CHARSET] = {0};
+    uint64_t q0 = next_zero(louds, 0);
+
+    louds->n_live = filter_family(louds, 1, q0, q0 + 1, reqs, hist, 0);
+    return louds->n_live;
+}
+
+/**
+ * @brief Prints the surviving words beneath a family of nodes
+ *
+ *  The survivors of the list that come before each word are printed first.
+ *
+ * @param louds     trie to print
+ * @param c         first node of the family
+ * @param n         number of nodes in the family
+ * @param p         position of the block of the first node in bits
+ * @param word      buffer of wordsize + 1 chars, holding the prefix
+ * @param depth     position of the letters of the family
+ * @param list      words inserted since the last build
+ * @param j         next survivor of the list to print
+ */
+static void print_family(louds_t *louds, uint32_t c, uint32_t n, uint64_t p, char *word, uint8_t depth, list_t *list, uint32_t *j){
+    uint32_t i;
+    uint64_t q;
+
+    for (i = c; i < c + n; ++i, p = q + 1){
+        q = next_zero(louds, p);
+        if (GET_BIT(louds->dead, i)) continue;
+        word[depth] = (louds->labels)[i];
+
+        if (q == p) {
+            memcpy(word + depth + 1, suffix(louds, i, depth), louds->wordsize - depth - 1);
+            for (; *j < list->n_alive && strcmp(LIST_WORD(list, (list->alive)[*j]), word) < 0; ++(*j)){
+                output_line(LIST_WORD(list, (list->alive)[*j]), louds->wordsize);
+            }
+            output_line(word, louds->wordsize);
+        } else {
+            print_family(louds, p - i + 1, q - p, select0(louds, p - i) + 1, word, depth + 1, list, j);
+        }
+    }
+}
+
+/**
+ * @brief Prints surviving words and list survivors in order
+ * @param louds     trie to print
+ * @param list      words inserted since the last build
+ */
+void louds_print(louds_t *louds, list_t *list){
+    char word[louds->wordsize + 1];
+    uint64_t q0 = next_zero(louds, 0);
+    uint32_t j = 0;
+
+    word[louds->wordsize] = '\0';
+    print_family(louds, 1, q0, q0 + 1, word, 0, list, &j);
+    for (; j < list->n_alive; ++j) output_line(LIST_WORD(list, (list->alive)[j]), louds->wordsize);
+}
+
+/**
+ * @brief Frees the trie and all its arrays
+ * @param louds     trie to free
+ */
+void louds_free(louds_t *louds){
+    release(louds);
+    free(louds);
+}
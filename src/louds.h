@@ -0,0 +1,121 @@
+/**
+ * @file louds.h
+ * @author Andrea Sgobbi
+ * @date 17 October 2026
+ * @brief Header containing the succinct trie used as a fourth engine
+ *
+ *  The pointer trie spends a 24B node and a separate status allocation on
+ *  every branch of the dictionary. The succinct trie has a node for every
+ *  letter down to the first one that tells a word apart, then the rest of the
+ *  word as a leaf suffix, all of it in a few flat arrays built once from the
+ *  sorted dictionary:
+ *
+ *      - LOUDS bitvector: nodes are numbered in level order (root = 0), and
+ *        node i writes a one for each child followed by a zero. With z(i) the
+ *        position of the i-th zero, the children of node i are the nodes
+ *        z(i-1) - i + 2 onwards, as many as the ones between z(i-1) and z(i)
+ *      - labels: one char per node, the letter leading to it
+ *      - leaves: bitvector of the nodes without children, with a rank
+ *        directory giving the index of a leaf among all the leaves
+ *      - suffixes: null terminated suffixes of the leaves in level order.
+ *        Leaves on the same level have suffixes of the same length, so a
+ *        suffix is found from the index of the leaf and two per-level tables
+ *
+ *  z() is answered by sampling every 64th zero and counting the zeros in each
+ *  word of the bitvector. Children of a node are visited together, so a walk
+ *  only needs z() once per branch and finds the other blocks by scanning.
+ *
+ *  The per-game state is a bitset with a bit for each node, set when the node
+ *  is pruned. Words inserted after the build are left to the survivor list
+ *  (list.h), and are encoded together with the rest at the start of a game
+ *  once there are more than 1/LOUDS_DELTA of the encoded words.
+ */
+#ifndef LOUDS_H_
+#define LOUDS_H_
+#include "game.h"
+#include "list.h"
+
+#define LOUDS_DELTA 8   // inserted words are encoded once they're 1/8 of the rest
+
+
+/** @brief Level order encoded trie with the prune state of the game
+ *
+ *      LOUDS:
+ *
+ *  - bits:             2*n_nodes - 1 bits, the degrees of the nodes in unary
+ *  - zrank:            zeros of bits before each of its words
+ *  - zsample:          zsample[j] is the word of bits holding zero 64*j
+ *  - labels:           labels[i] is the letter of node i (unused for the root)
+ *  - leaves/lrank:     bitvector of the leaves and leaves before each word
+ *  - suffixes:         suffixes of the leaves, level by level
+ *  - lvl_leaf:         index of the first leaf whose letter is at position p
+ *  - lvl_off:          offset in suffixes of the first leaf of position p
+ *  - dead:             bit i is set if node i was pruned in this game
+ *  - n_nodes/n_words:  number of nodes and of encoded words
+ *  - n_live:           encoded words that survived the game so far
+ */
+typedef struct louds {
+    uint64_t *bits;
+    uint32_t *zrank;
+    uint32_t *zsample;
+    uint8_t *labels;
+    uint64_t *leaves;
+    uint32_t *lrank;
+    char *suffixes;
+    uint32_t *lvl_leaf;
+    size_t *lvl_off;
+    uint64_t *dead;
+    uint32_t n_nodes, n_words, n_live;
+    uint8_t wordsize;
+} louds_t;
+
+/**
+ * @brief Allocates an empty trie                                 O(1)
+ * @param wordsize  size of the words to store
+ * @return louds_t* the new trie
+ */
+louds_t *louds_init(uint8_t);
+
+/**
+ * @brief Starts a new game, all the words survive                O(n)
+ *
+ *  Must be called right after list_reset(). If the list holds enough words
+ *  they're encoded with the others, and the list must then be emptied by the
+ *  caller (along with whatever validates its words).
+ *
+ * @param louds     trie to reset
+ * @param list      words inserted since the last build
+ * @return int      1 if the words of the list were encoded, 0 if not
+ */
+int louds_reset(louds_t *, list_t *);
+
+/**
+ * @brief Checks if a word is encoded in the trie                 O(k)
+ * @param louds     trie to search
+ * @param word      word to look for (wordsize chars)
+ * @return int      1 if found, 0 if not
+ */
+int louds_search(louds_t *, const char *);
+
+/**
+ * @brief Prunes the words that don't pass the bounds             O(n)
+ * @param louds     trie to filter
+ * @param reqs      requirements struct pointer
+ * @return uint32_t number of surviving encoded words
+ */
+uint32_t louds_filter(louds_t *, req_t *);
+
+/**
+ * @brief Prints surviving words and list survivors in order      O(n)
+ * @param louds     trie to print
+ * @param list      words inserted since the last build
+ */
+void louds_print(louds_t *, list_t *);
+
+/**
+ * @brief Frees the trie and all its arrays
+ * @param louds     trie to free
+ */
+void louds_free(louds_t *);
+
+#endif
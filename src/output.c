@@ -0,0 +1,175 @@
+#include <errno.h>
+#include <unistd.h>
+#include "output.h"
+#include "stats.h"
+
+static char *reserve(size_t);
+
+static __thread char *buf = NULL;    // only threads that write get one
+static __thread size_t used = 0;
+static __thread int out_fd = STDOUT_FILENO;
+static __thread uint8_t interactive = 0;
+static __thread record_t *rec = NULL;  // set while recording
+static uint8_t registered = 0;
+
+
+/**
+ * @brief Sets the file descriptor of the calling thread, registers the flush at exit
+ *
+ *  Terminals get each line as soon as it's complete, anything else only sees
+ *  a write() every OUTPUT_BUF bytes. The handler is registered by the first
+ *  call, which comes from the main thread before any other is started, and
+ *  flushes the buffer of the thread that exits. The buffer itself is only
+ *  allocated by the first call of each thread and then kept, so the workers
+ *  of the prune and the build, which never write, don't pay for it.
+ *
+ * @param fd        file descriptor to write to
+ */
+void output_open(int fd){
+    if (buf == NULL) {
+        buf = (char *)malloc(OUTPUT_BUF);
+        if (buf == NULL) exit(EXIT_FAILURE);
+    }
+    out_fd = fd;
+    used = 0;
+    interactive = isatty(fd);
+    if (!registered) {
+        registered = 1;
+        atexit(output_flush);
+    }
+}
+
+/**
+ * @brief Reserves room for size bytes at the end of the buffer
+ *
+ *  While recording the bytes go to the end of the record, which doubles its
+ *  capacity when it fills up.
+ *
+ * @param size      number of bytes to reserve (at most OUTPUT_BUF)
+ * @return char*    where to write the bytes
+ */
+static char *reserve(size_t size){
+    char *dst;
+
+    if (rec != NULL) {
+        if (rec->cap - rec->len < size) {
+            rec->cap = (rec->cap > size) ? 2 * rec->cap : 2 * size + OUTPUT_BUF;
+            rec->text = (char *)realloc(rec->text, rec->cap);
+            if (rec->text == NULL) exit(EXIT_FAILURE);
+        }
+        dst = rec->text + rec->len;
+        rec->len += size;
+        return dst;
+    }
+
+    STAT(bytes_written, size);
+    if (OUTPUT_BUF - used < size) output_flush();
+    dst = buf + used;
+    used += size;
+
+    return dst;
+}
+
+/**
+ * @brief Writes a line, a newline is appended
+ * @param line      characters of the line
+ * @param len       number of characters
+ */
+void output_line(const char *line, size_t len){
+    char *dst = reserve(len + 1);
+
+    memcpy(dst, line, len);
+    dst[len] = '\n';
+    if (interactive) output_flush();
+}
+
+/**
+ * @brief Writes a non negative number on its own line
+ *
+ *  The digits are generated backwards in a small scratch buffer.
+ *
+ * @param x         number to write
+ */
+void output_number(uint32_t x){
+    char digits[11], *p = digits + sizeof(digits);
+
+    *(--p) = '\n';
+    do {
+        *(--p) = '0' + x % 10;
+        x /= 10;
+    } while (x != 0);
+
+    memcpy(reserve(digits + sizeof(digits) - p), p, digits + sizeof(digits) - p);
+    if (interactive) output_flush();
+}
+
+/**
+ * @brief Writes a line made of a prefix and a suffix
+ *
+ *  Used to print trie words, which are split between the prefix collected on
+ *  the way down and the suffix stored in the leaf.
+ *
+ * @param prefix    first part of the line
+ * @param plen      length of the prefix
+ * @param sfx       second part of the line
+ * @param slen      length of the suffix
+ */
+void output_word(const char *prefix, size_t plen, const char *sfx, size_t slen){
+    char *dst = reserve(plen + slen + 1);
+
+    memcpy(dst, prefix, plen);
+    memcpy(dst + plen, sfx, slen);
+    dst[plen + slen] = '\n';
+    if (interactive) output_flush();
+}
+
+/**
+ * @brief Starts recording the output of the calling thread
+ * @param r         record to overwrite
+ */
+void output_record(record_t *r){
+    r->len = 0;
+    rec = r;
+}
+
+/**
+ * @brief Stops recording, the output goes back to the buffer
+ */
+void output_stop(void){
+    rec = NULL;
+}
+
+/**
+ * @brief Writes out a record
+ *
+ *  The record is copied through the buffer OUTPUT_BUF bytes at a time.
+ *
+ * @param r         record to write
+ */
+void output_replay(const record_t *r){
+    size_t done, n;
+
+    for (done = 0; done < r->len; done += n){
+        n = (r->len - done < OUTPUT_BUF) ? r->len - done : OUTPUT_BUF;
+        memcpy(reserve(n), r->text + done, n);
+    }
+    if (interactive) output_flush();
+}
+
+/**
+ * @brief Writes out everything in the buffer
+ *
+ *  Write errors can't be reported anywhere, so the buffer is dropped.
+ */
+void output_flush(void){
+    size_t done = 0;
+    ssize_t w;
+
+    while (done < used){
+        w = write(out_fd, buf + done, used - done);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) break;
+        done += w;
+    }
+    used = 0;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file output.h
+ * @author Andrea Sgobbi
+ * @date 16 October 2026
+ * @brief Header containing the buffered output writer
+ *
+ *  +stampa_filtrate used to print each word with a fputs() of the prefix and a
+ *  puts() of the suffix, and every guess cost another puts()/printf(), so big
+ *  dumps meant millions of locked libc calls. Lines are instead built straight
+ *  into a single buffer with memcpy and handed to write() when it fills up.
+ *
+ *  The buffer is flushed by an atexit() handler, which covers every exit()
+ *  path of the game loop. When the output is a terminal each line is flushed
+ *  right away, like stdio would do, so that the game stays interactive.
+ *
+ *  The writer state is thread local, so each session of the server (server.h)
+ *  opens and flushes its own buffer on its own socket. The buffer is only
+ *  allocated by output_open(), threads that never write don't carry one.
+ *
+ *  Output can also be recorded: between output_record() and output_stop()
+ *  lines are kept in a growing record instead, which can then be read back or
+ *  written out (any number of times) with output_replay().
+ */
+#ifndef OUTPUT_H_
+#define OUTPUT_H_
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define OUTPUT_BUF (1 << 18)    // bytes buffered before each write()
+#define OUTPUT_STR(str) output_line((str), sizeof(str) - 1)
+
+/** @brief Recorded output, text is reused (and grown) by each recording */
+typedef struct record {
+    char *text;
+    size_t len;
+    size_t cap;
+} record_t;
+
+/**
+ * @brief Sets the file descriptor of the calling thread, registers the flush at exit
+ *
+ *  Must be called by a thread before it writes anything.
+ *
+ * @param fd        file descriptor to write to
+ */
+void output_open(int);
+
+/**
+ * @brief Writes a line, a newline is appended                     O(len)
+ * @param line      characters of the line
+ * @param len       number of characters
+ */
+void output_line(const char *, size_t);
+
+/**
+ * @brief Writes a non negative number on its own line             O(1)
+ * @param x         number to write
+ */
+void output_number(uint32_t);
+
+/**
+ * @brief Writes a line made of a prefix and a suffix             O(len)
+ * @param prefix    first part of the line
+ * @param plen      length of the prefix
+ * @param sfx       second part of the line
+ * @param slen      length of the suffix
+ */
+void output_word(const char *, size_t, const char *, size_t);
+
+/**
+ * @brief Starts recording the output of the calling thread        O(1)
+ * @param rec       record to overwrite
+ */
+void output_record(record_t *);
+
+/**
+ * @brief Stops recording, the output goes back to the buffer     O(1)
+ */
+void output_stop(void);
+
+/**
+ * @brief Writes out a record                                     O(len)
+ * @param rec       record to write
+ */
+void output_replay(const record_t *);
+
+/**
+ * @brief Writes out everything in the buffer
+ */
+void output_flush(void);
+
+#endif
@@ -0,0 +1,101 @@
+#include <stdlib.h>
+#include <pthread.h>
+#include "pool.h"
+
+static void *worker(void *);
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;  // a job was handed out
+static pthread_cond_t done = PTHREAD_COND_INITIALIZER;  // the last worker finished
+static pool_job_t job = NULL;
+static void *job_arg = NULL;
+static uint32_t rounds = 0;     // jobs handed out so far
+static uint8_t busy = 0;        // workers still running the current job
+static uint8_t size = 1;
+
+
+/**
+ * @brief Runs every job handed out by pool_run(), forever
+ *
+ *  Counting the rounds lets a worker tell a new job from a spurious wakeup,
+ *  or from the job it just finished.
+ *
+ * @param arg       index of the worker
+ * @return void*    never returns
+ */
+static void *worker(void *arg){
+    uint8_t id = (uint8_t)(uintptr_t) arg;
+    uint32_t seen = 0;
+    pool_job_t fn;
+    void *fn_arg;
+
+    pthread_mutex_lock(&lock);
+    while (1){
+        while (rounds == seen) pthread_cond_wait(&wake, &lock);
+        seen = rounds;
+        fn = job;
+        fn_arg = job_arg;
+        pthread_mutex_unlock(&lock);
+
+        fn(fn_arg, id);
+
+        pthread_mutex_lock(&lock);
+        if (--busy == 0) pthread_cond_signal(&done);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Starts the workers of the pool, must be called once
+ *
+ *  Workers that can't be started are left out, the pool is just smaller.
+ *
+ * @param n         threads of the pool, the calling thread included
+ */
+void pool_start(uint8_t n){
+    pthread_t thread;
+
+    for (size = 1; size < n; ++size){
+        if (pthread_create(&thread, NULL, worker, (void *)(uintptr_t) size) != 0) break;
+        pthread_detach(thread);
+    }
+}
+
+/**
+ * @brief Returns the number of threads of the pool
+ * @return uint8_t  threads that run each job, at least 1
+ */
+uint8_t pool_size(void){
+    return size;
+}
+
+/**
+ * @brief Runs a job on every thread of the pool, returns when all are done
+ *
+ *  The calling thread runs the job as the thread 0, then waits for the
+ *  workers. With a single thread nothing is locked at all.
+ *
+ * @param fn        function run by each thread
+ * @param arg       argument shared by the threads
+ */
+void pool_run(pool_job_t fn, void *arg){
+    if (size == 1) {
+        fn(arg, 0);
+        return;
+    }
+
+    pthread_mutex_lock(&lock);
+    job = fn;
+    job_arg = arg;
+    busy = size - 1;
+    ++rounds;
+    pthread_cond_broadcast(&wake);
+    pthread_mutex_unlock(&lock);
+
+    fn(arg, 0);
+
+    pthread_mutex_lock(&lock);
+    while (busy != 0) pthread_cond_wait(&done, &lock);
+    pthread_mutex_unlock(&lock);
+}
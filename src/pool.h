@@ -0,0 +1,46 @@
+/**
+ * @file pool.h
+ * @author Andrea Sgobbi
+ * @date 17 October 2026
+ * @brief Header containing the worker pool of the game loop
+ *
+ *  The parallel prune, the parallel build and +suggerisci used to start their
+ *  threads with pthread_create() on every call and join them at the end: on
+ *  long streams of games that's a clone() and a new stack for each worker of
+ *  each guess. The workers are instead started once, by pool_start(), and then
+ *  sleep on a condition variable until pool_run() hands them the next job.
+ *
+ *  A job is a single function that every thread of the pool runs once, the
+ *  calling thread included, with the same argument and the index of the
+ *  thread: the jobs of the game loop split their own work with an atomic
+ *  counter. The pool is only driven by the main thread, server sessions do
+ *  their work on their own thread.
+ */
+#ifndef POOL_H_
+#define POOL_H_
+#include <stdint.h>
+
+/** @brief Work run by every thread of the pool, with its index (0 is the caller) */
+typedef void (*pool_job_t)(void *, uint8_t);
+
+
+/**
+ * @brief Starts the workers of the pool, must be called once      O(n)
+ * @param n         threads of the pool, the calling thread included
+ */
+void pool_start(uint8_t);
+
+/**
+ * @brief Returns the number of threads of the pool                O(1)
+ * @return uint8_t  threads that run each job, at least 1
+ */
+uint8_t pool_size(void);
+
+/**
+ * @brief Runs a job on every thread of the pool, returns when all are done
+ * @param job       function run by each thread
+ * @param arg       argument shared by the threads
+ */
+void pool_run(pool_job_t, void *);
+
+#endif
@@ -0,0 +1,334 @@
+#include <stdio.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "server.h"
+#include "game.h"
+#include "input.h"
+#include "output.h"
+#include "suggest.h"
+
+/** @brief State of a connection, nothing in here is shared
+ *
+ *      SESSION:
+ *
+ *  - in:               reader on the socket
+ *  - own:              words inserted by the session, with their own order and
+ *                      survivors (list.h)
+ *  - own_dict:         hash set of the words in own
+ *  - alive/n_alive:    handles of the shared words alive in the current game,
+ *                      in lexicographical order
+ *  - listing:          survivors recorded for +suggerisci
+ */
+typedef struct session {
+    input_t in;
+    list_t *own;
+    hset_t *own_dict;
+    uint32_t *alive;
+    uint32_t n_alive;
+    record_t listing;
+} session_t;
+
+static char *session_line(session_t *, size_t *);
+static int is_word(const char *, size_t);
+static int insert_words(session_t *, req_t *);
+static uint32_t filter_session(session_t *, req_t *);
+static void print_session(session_t *);
+static void suggest_session(session_t *);
+static int play(session_t *);
+static void serve_session(int);
+static void *worker(void *);
+
+static list_t *shared = NULL;   // read only once serving starts
+static hset_t *shared_dict = NULL;
+static uint8_t wordsize;
+static int listen_fd = -1;
+
+
+/**
+ * @brief Returns the next line of a session
+ *
+ *  Replies are buffered until the session would have to wait for the client,
+ *  then flushed: the client gets all of them before sending anything else.
+ *
+ * @param s         session to read from
+ * @param len       set to the length of the line
+ * @return char*    start of the line, NULL if the client closed the session
+ */
+static char *session_line(session_t *s, size_t *len){
+    if (!input_ready(&s->in)) output_flush();
+    return input_line(&s->in, len);
+}
+
+/**
+ * @brief Checks that a line from a client can be used as a word
+ *
+ *  Unlike stdin, clients aren't trusted to follow the protocol: a char out of
+ *  the alphabet would index past conversion_table and the letter histograms.
+ *
+ * @param line      line to check
+ * @param len       length of the line
+ * @return int      1 if the line has the size of the words and only letters
+ *                  of the alphabet, 0 if not
+ */
+static int is_word(const char *line, size_t len){
+    size_t i;
+
+    if (len != wordsize) return 0;
+    for (i = 0; i < len; ++i){
+        if ((unsigned char) line[i] >= 128 || conversion_table[(int) line[i]] >= CHARSET) return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Reads words into the overlay of a session until +inserisci_fine
+ *
+ *  Lines that aren't words (is_word()) are skipped. During a game (reqs
+ *  given) each word is checked right away, and the valid ones are merged with
+ *  the survivors of the overlay.
+ *
+ * @param s         session inserting the words
+ * @param reqs      requirements of the current game, NULL between games
+ * @return int      0 if the client closed the session, 1 otherwise
+ */
+static int insert_words(session_t *s, req_t *reqs){
+    uint8_t hist[CHARSET] = {0};
+    uint32_t h, n = 0;
+    size_t len;
+    char *line;
+
+    while ((line = session_line(s, &len)) != NULL && line[0] != '+'){
+        if (!is_word(line, len)) continue;
+        h = list_add(s->own, line);
+        hset_add(s->own_dict, h);
+        if (reqs != NULL && check_leaf(LIST_WORD(s->own, h), reqs, hist, 0)) s->own->alive[s->own->n_alive + n++] = h;
+    }
+    if (reqs != NULL) list_merge_alive(s->own, n);
+
+    return line != NULL;
+}
+
+/**
+ * @brief Filters the shared and the inserted survivors of a session
+ * @param s         session to filter
+ * @param reqs      constraints added by the last guess (delta of eval_guess())
+ * @return uint32_t number of survivors
+ */
+static uint32_t filter_session(session_t *s, req_t *reqs){
+    uint8_t hist[CHARSET] = {0};
+    uint32_t i, n = 0, *alive = s->alive;
+    list_t *own = s->own;
+
+    for (i = 0; i < s->n_alive; ++i){
+        if (check_leaf(LIST_WORD(shared, alive[i]), reqs, hist, 0)) alive[n++] = alive[i];
+    }
+    s->n_alive = n;
+
+    for (i = 0, n = 0; i < own->n_alive; ++i){
+        if (check_leaf(LIST_WORD(own, own->alive[i]), reqs, hist, 0)) own->alive[n++] = own->alive[i];
+    }
+    own->n_alive = n;
+
+    return s->n_alive + own->n_alive;
+}
+
+/**
+ * @brief Prints the survivors of a session in lexicographical order
+ *
+ *  The shared and the inserted survivors are both sorted, so they're merged.
+ *
+ * @param s         session to print
+ */
+static void print_session(session_t *s){
+    uint32_t i = 0, j = 0;
+    list_t *own = s->own;
+    char *a, *b;
+
+    while (i < s->n_alive || j < own->n_alive){
+        a = (i < s->n_alive) ? LIST_WORD(shared, s->alive[i]) : NULL;
+        b = (j < own->n_alive) ? LIST_WORD(own, own->alive[j]) : NULL;
+
+        if (b == NULL || (a != NULL && strcmp(a, b) < 0)) {
+            output_line(a, wordsize);
+            ++i;
+        } else {
+            output_line(b, wordsize);
+            ++j;
+        }
+    }
+}
+
+/**
+ * @brief Prints the best next guesses of a session
+ *
+ *  Same as +suggerisci on stdin, on the survivors recorded by print_session().
+ *  The scoring runs on the thread of the session: the pool (pool.h) belongs
+ *  to the game loop, and the other workers are busy with their own sessions.
+ *
+ * @param s         session asking
+ */
+static void suggest_session(session_t *s){
+    output_record(&(s->listing));
+    print_session(s);
+    output_stop();
+    suggest(s->listing.text, s->listing.len / (wordsize + 1), wordsize, 0);
+}
+
+/**
+ * @brief Plays a game of a session, after its +nuova_partita
+ *
+ *  Same loop as new_game() with ENGINE_LIST, on the survivors of the session.
+ *  Lines that aren't words (is_word()) are never in the dictionary, and a
+ *  reference that isn't a word ends the session.
+ *
+ * @param s         session playing
+ * @return int      0 if the client closed the session, 1 otherwise
+ */
+static int play(session_t *s){
+    req_t *reqs;
+    int guesses;
+    size_t len;
+    char *line;
+
+    if ((line = session_line(s, &len)) == NULL || !is_word(line, len)) return 0;
+    reqs = generate_reqs(line, wordsize);
+    if ((line = session_line(s, &len)) == NULL) {
+        free_reqs(reqs);
+        return 0;
+    }
+    guesses = parse_number(line, len);
+
+    list_reset(s->own);
+    if (shared->n_dict > 0) memcpy(s->alive, shared->dict, shared->n_dict * sizeof(uint32_t));
+    s->n_alive = shared->n_dict;
+
+    while (guesses > 0 && (line = session_line(s, &len)) != NULL){
+
+        if (line[0] == '+') {
+            if (IS_CMD(line, len, PRINT)) print_session(s);
+            else if (IS_CMD(line, len, SUGGEST)) suggest_session(s);
+            else if (IS_CMD(line, len, INSERT_START) && !insert_words(s, reqs)) line = NULL;
+            if (line == NULL) break;
+
+        } else if (len == wordsize && memcmp(reqs->ref, line, wordsize) == 0) {
+            OUTPUT_STR("ok");
+            break;
+        } else if (!is_word(line, len) || (!hset_contains(shared_dict, line) && !hset_contains(s->own_dict, line))) {
+            OUTPUT_STR("not_exists");
+        } else {
+            eval_guess(line, wordsize, reqs);
+            output_number(filter_session(s, reqs->delta));
+            --guesses;
+        }
+    }
+    if (guesses == 0) OUTPUT_STR("ko");
+
+    free_reqs(reqs);
+    return line != NULL;
+}
+
+/**
+ * @brief Serves a connection until the client closes it
+ * @param fd        socket of the connection, closed when done
+ */
+static void serve_session(int fd){
+    session_t s;
+    size_t len;
+    char *line;
+
+    input_open(&s.in, fd);
+    output_open(fd);
+    s.own = list_init(wordsize);
+    s.own_dict = hset_init(s.own);
+    s.alive = (uint32_t *)malloc((shared->n_dict + 1) * sizeof(uint32_t));
+    s.n_alive = 0;
+    s.listing.text = NULL;
+    s.listing.len = s.listing.cap = 0;
+    if (s.alive == NULL) exit(EXIT_FAILURE);
+
+    while ((line = session_line(&s, &len)) != NULL){
+        if (IS_CMD(line, len, NEW_GAME)) {
+            if (!play(&s)) break;
+        } else if (IS_CMD(line, len, INSERT_START)) {
+            if (!insert_words(&s, NULL)) break;
+        }
+    }
+    output_flush();
+
+    input_close(&s.in);
+    list_free(s.own);
+    hset_free(s.own_dict);
+    free(s.alive);
+    free(s.listing.text);
+    close(fd);
+}
+
+/**
+ * @brief Accepts connections and serves them one at a time
+ * @param arg       unused
+ * @return void*    NULL, if accept() fails for good
+ */
+static void *worker(void *arg){
+    int fd;
+
+    (void) arg;
+    while (1){
+        fd = accept(listen_fd, NULL, NULL);
+        if (fd >= 0) serve_session(fd);
+        else if (errno != EINTR && errno != ECONNABORTED) break;
+    }
+    perror("accept");
+
+    return NULL;
+}
+
+/**
+ * @brief Serves sessions on a dictionary forever
+ *
+ *  SIGPIPE is ignored, so that a client leaving before reading its replies
+ *  only ends its own session.
+ *
+ * @param path      path of the Unix domain socket, replaced if it exists
+ * @param words     word store of the dictionary, with no pending words
+ * @param set       hash set of the dictionary
+ * @param workers   number of sessions served at the same time
+ */
+void serve(const char *path, list_t *words, hset_t *set, uint8_t workers){
+    struct sockaddr_un addr;
+    pthread_t pool[workers];
+    uint8_t i;
+
+    shared = words;
+    shared_dict = set;
+    wordsize = words->wordsize;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "%s: socket path too long\n", path);
+        exit(EXIT_FAILURE);
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    unlink(path);
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0 || bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(listen_fd, SERVER_BACKLOG) < 0
+    ) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    for (i = 0; i < workers; ++i){
+        if (pthread_create(pool + i, NULL, worker, NULL) != 0) exit(EXIT_FAILURE);
+    }
+    for (i = 0; i < workers; ++i) pthread_join(pool[i], NULL);
+
+    close(listen_fd);
+    unlink(path);
+}
@@ -0,0 +1,44 @@
+/**
+ * @file server.h
+ * @author Andrea Sgobbi
+ * @date 17 October 2026
+ * @brief Header containing the multi-session server
+ *
+ *  A process only ever plays a single stream of games, since the trie keeps
+ *  the prune state of the current game inside its nodes: running many streams
+ *  meant many processes, each paying for the whole load and for its own copy
+ *  of the dictionary. The server loads the dictionary once, in the list/hash
+ *  set layout of ENGINE_LIST, and then serves games over a Unix domain socket.
+ *  Each connection is a session that speaks the same protocol as stdin, minus
+ *  the word size and the initial dictionary.
+ *
+ *  The shared dictionary is never written after the load. Everything a game
+ *  changes belongs to its session: the requirements, the handles of the
+ *  dictionary words still alive, and an overlay with the words the session
+ *  inserted, which only that session sees (in all of its games). Sessions are
+ *  served by a fixed pool of worker threads, each one accepting a connection
+ *  and serving it until the client closes it.
+ */
+#ifndef SERVER_H_
+#define SERVER_H_
+#include <stdint.h>
+#include "list.h"
+#include "hset.h"
+
+#define SERVER_BACKLOG 64   // pending connections queued by listen()
+
+
+/**
+ * @brief Serves sessions on a dictionary forever
+ *
+ *  The dictionary is read from the input (read_dictionary()) or mapped from
+ *  an image (image.h). Exits with a failure if the socket can't be created.
+ *
+ * @param path      path of the Unix domain socket, replaced if it exists
+ * @param words     word store of the dictionary, with no pending words
+ * @param set       hash set of the dictionary
+ * @param workers   number of sessions served at the same time
+ */
+void serve(const char *, list_t *, hset_t *, uint8_t);
+
+#endif
@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "stats.h"
+
+#ifdef STATS
+static uint16_t bucket(uint64_t);
+static uint64_t bucket_top(uint16_t);
+static uint64_t percentile(uint8_t, double);
+static void print_latencies(void);
+static void print_table(const char *, counters_t *);
+static void add_to_totals(void);
+static void report_totals(void);
+
+counters_t stats[STAT_CMDS];
+uint8_t stat_cmd = STAT_LOAD;
+
+static counters_t totals[STAT_CMDS];
+static uint8_t enabled = 0;
+static uint32_t games = 0;
+
+static const char *names[STAT_CMDS] = {"load", "reset", "guess", "print", "insert", "suggest"};
+
+static uint64_t hist[LAT_KINDS][LAT_BUCKETS];
+static uint64_t samples[LAT_KINDS], longest[LAT_KINDS];
+
+static const char *lat_names[LAT_KINDS] = {
+    "search", "eval", "first", "filter", "insert", "print", "reset", "suggest"
+};
+
+
+/**
+ * @brief Returns a monotonic timestamp
+ * @return uint64_t nanoseconds
+ */
+uint64_t stats_now(void){
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+/**
+ * @brief Index of the histogram bucket of a value
+ *
+ *  Values below 8 have a bucket each, after that every power of two is split
+ *  in 8 buckets using the 3 bits after the leading one.
+ *
+ * @param v         value in nanoseconds
+ * @return uint16_t bucket index
+ */
+static uint16_t bucket(uint64_t v){
+    uint8_t e;
+
+    if (v < 8) return v;
+    e = 63 - __builtin_clzll(v);
+    return (e - 2)*8 + ((v >> (e - 3)) & 7);
+}
+
+/**
+ * @brief Largest value that falls in a bucket
+ * @param b         bucket index
+ * @return uint64_t value in nanoseconds
+ */
+static uint64_t bucket_top(uint16_t b){
+    uint8_t e = b/8 + 2;
+
+    if (b < 8) return b;
+    return ((uint64_t)(8 + b%8) << (e - 3)) + ((uint64_t)1 << (e - 3)) - 1;
+}
+
+/**
+ * @brief Adds the time elapsed since start to a histogram
+ * @param kind      histogram, one of the LAT_ values
+ * @param start     timestamp taken with stats_now()
+ */
+void stats_record(uint8_t kind, uint64_t start){
+    uint64_t t = stats_now() - start;
+
+    ++(hist[kind][bucket(t)]);
+    ++(samples[kind]);
+    if (t > longest[kind]) longest[kind] = t;
+}
+
+/**
+ * @brief Value below which a fraction of the samples fall
+ *
+ *  Returns the top of the bucket holding the percentile, capped to the actual
+ *  maximum so that it's never larger than any value seen.
+ *
+ * @param kind      histogram
+ * @param p         fraction, between 0 and 1
+ * @return uint64_t value in nanoseconds
+ */
+static uint64_t percentile(uint8_t kind, double p){
+    uint64_t rank = (uint64_t)(p * samples[kind]), seen = 0;
+    uint16_t b;
+
+    if (rank >= samples[kind]) rank = samples[kind] - 1;
+    for (b = 0; b < LAT_BUCKETS; ++b){
+        seen += hist[kind][b];
+        if (seen > rank) break;
+    }
+
+    return (bucket_top(b) < longest[kind]) ? bucket_top(b) : longest[kind];
+}
+
+/**
+ * @brief Writes the percentiles of every histogram with samples, in us
+ */
+static void print_latencies(void){
+    uint8_t k;
+
+    fprintf(stderr, "latency (us)\n%-7s %10s %10s %10s %10s %10s\n", "", "n", "p50", "p90", "p99", "max");
+    for (k = 0; k < LAT_KINDS; ++k){
+        if (samples[k] == 0) continue;
+        fprintf(stderr, "%-7s %10" PRIu64 " %10.1f %10.1f %10.1f %10.1f\n", lat_names[k], samples[k],
+                percentile(k, 0.5) / 1e3, percentile(k, 0.9) / 1e3, percentile(k, 0.99) / 1e3,
+                longest[k] / 1e3);
+    }
+}
+
+
+/**
+ * @brief Writes a table of counters, one row per kind of command
+ * @param title     title of the table
+ * @param c         counters, STAT_CMDS of them
+ */
+static void print_table(const char *title, counters_t *c){
+    uint8_t i;
+
+    fprintf(stderr, "%s\n%-7s %8s %11s %11s %11s %12s %10s %9s %12s %11s %12s %12s\n", title,
+            "", "cmds", "visited", "pruned", "leaves", "chars", "lookups", "allocs",
+            "alloc_B", "rows", "read_B", "written_B");
+
+    for (i = 0; i < STAT_CMDS; ++i){
+        if (c[i].commands == 0 && c[i].bytes_read == 0) continue;
+        fprintf(stderr, "%-7s %8" PRIu64 " %11" PRIu64 " %11" PRIu64 " %11" PRIu64 " %12" PRIu64 " %10" PRIu64
+                        " %9" PRIu64 " %12" PRIu64 " %11" PRIu64 " %12" PRIu64 " %12" PRIu64 "\n",
+                names[i], c[i].commands, c[i].nodes_visited, c[i].nodes_pruned, c[i].leaves_checked,
+                c[i].chars_compared, c[i].child_lookups, c[i].allocs, c[i].alloc_bytes,
+                c[i].rows_checked, c[i].bytes_read, c[i].bytes_written);
+    }
+}
+
+/**
+ * @brief Adds the current counters to the totals, field by field
+ */
+static void add_to_totals(void){
+    uint64_t *t = (uint64_t *)totals, *s = (uint64_t *)stats;
+    size_t i;
+
+    for (i = 0; i < STAT_CMDS * (sizeof(counters_t) / sizeof(uint64_t)); ++i) t[i] += s[i];
+}
+
+/**
+ * @brief Adds whatever is left to the totals and writes them, run at exit
+ */
+static void report_totals(void){
+    add_to_totals();
+    print_table("total", totals);
+    print_latencies();
+}
+
+/**
+ * @brief Enables the report
+ * @return int      0 on success
+ */
+int stats_enable(void){
+    enabled = 1;
+    atexit(report_totals);
+    return 0;
+}
+
+/**
+ * @brief Writes the counters of the game that just ended to stderr
+ */
+void stats_game_end(void){
+    char title[32];
+
+    if (!enabled) return;
+
+    snprintf(title, sizeof(title), "game %u", ++games);
+    print_table(title, stats);
+
+    add_to_totals();
+    memset(stats, 0, sizeof(stats));
+}
+
+#else
+
+/**
+ * @brief The counters weren't compiled in, the report can't be enabled
+ * @return int      -1
+ */
+int stats_enable(void){
+    return -1;
+}
+
+/**
+ * @brief Nothing to report without STATS
+ */
+void stats_game_end(void){
+}
+
+#endif
@@ -0,0 +1,116 @@
+/**
+ * @file stats.h
+ * @author Andrea Sgobbi
+ * @date 17 October 2026
+ * @brief Header containing the optional hot path counters
+ *
+ *  The counters are only compiled in with -DSTATS (make stats), otherwise every
+ *  STAT() expands to nothing and the release build is left untouched. Each
+ *  counter is kept per kind of command, switched with STAT_CMD() by the game
+ *  loop, and when the program runs with --stats a table is written to stderr
+ *  at the end of every game, followed by the totals when the program exits.
+ *
+ *  Counters are updated with relaxed atomics, since the pruning workers share
+ *  them: it's slower, but only in the STATS build.
+ *
+ *  The same build also times the steps of each command with TIMED(), and keeps
+ *  the timings in log-linear histograms (8 buckets per power of two, so every
+ *  bucket is within 12.5% of its values). p50/p90/p99/max of every kind are
+ *  written along with the totals.
+ */
+#ifndef STATS_H_
+#define STATS_H_
+#include <stdint.h>
+
+#define STAT_LOAD    0      // dictionary read before the first game
+#define STAT_RESET   1      // setting up a new game
+#define STAT_GUESS   2
+#define STAT_PRINT   3
+#define STAT_INSERT  4
+#define STAT_SUGGEST 5
+#define STAT_CMDS    6
+
+#define LAT_SEARCH  0       // dictionary lookup of a guess
+#define LAT_EVAL    1       // eval_guess()
+#define LAT_FIRST   2       // pruning or filtering after the first guess of a game
+#define LAT_FILTER  3       // pruning or filtering after any later guess
+#define LAT_INSERT  4       // whole insertion batch
+#define LAT_PRINT   5       // +stampa_filtrate
+#define LAT_RESET   6       // clearing the engine between games
+#define LAT_SUGGEST 7       // +suggerisci
+#define LAT_KINDS   8
+#define LAT_BUCKETS 512
+
+
+/** @brief Counters for a kind of command
+ *
+ *      COUNTERS:
+ *
+ *  - commands:         commands of this kind
+ *  - nodes_visited:    trie nodes examined by prune_child()
+ *  - nodes_pruned:     trie nodes cut off by the prune (PRUNE or TEMP_PRUNE)
+ *  - leaves_checked:   calls to check_leaf()
+ *  - chars_compared:   suffix characters tested by check_leaf()
+ *  - child_lookups:    calls to get_child() (insertions and searches)
+ *  - allocs:           blocks and strings handed out by the arena
+ *  - alloc_bytes:      bytes handed out by the arena
+ *  - rows_checked:     words checked by the list and columns engines
+ *  - bytes_read:       input bytes consumed, newlines included
+ *  - bytes_written:    output bytes produced
+ */
+typedef struct counters {
+    uint64_t commands;
+    uint64_t nodes_visited, nodes_pruned;
+    uint64_t leaves_checked, chars_compared;
+    uint64_t child_lookups;
+    uint64_t allocs, alloc_bytes;
+    uint64_t rows_checked;
+    uint64_t bytes_read, bytes_written;
+} counters_t;
+
+#ifdef STATS
+extern counters_t stats[STAT_CMDS];
+extern uint8_t stat_cmd;
+
+#define STAT(field, n) ((void) __atomic_fetch_add(&(stats[stat_cmd].field), (n), __ATOMIC_RELAXED))
+#define STAT_CMD(cmd) ((void) (stat_cmd = (cmd), ++(stats[cmd].commands)))
+#define TIMED(kind, stmt) do {              \
+        uint8_t kind_ = (kind);             \
+        uint64_t start_ = stats_now();      \
+        stmt;                               \
+        stats_record(kind_, start_);        \
+    } while (0)
+
+/**
+ * @brief Returns a monotonic timestamp
+ * @return uint64_t nanoseconds
+ */
+uint64_t stats_now(void);
+
+/**
+ * @brief Adds the time elapsed since start to a histogram
+ * @param kind      histogram, one of the LAT_ values
+ * @param start     timestamp taken with stats_now()
+ */
+void stats_record(uint8_t, uint64_t);
+#else
+#define STAT(field, n) ((void) 0)
+#define STAT_CMD(cmd) ((void) 0)
+#define TIMED(kind, stmt) do { (void) (kind); stmt; } while (0)
+#endif
+
+/**
+ * @brief Enables the report, fails if the counters weren't compiled in
+ * @return int      0 on success, -1 without STATS
+ */
+int stats_enable(void);
+
+/**
+ * @brief Writes the counters of the game that just ended to stderr
+ *
+ *  The counters are then added to the totals and cleared. Does nothing unless
+ *  the report was enabled.
+ */
+void stats_game_end(void);
+
+#endif
@@ -0,0 +1,160 @@
+#include <math.h>
+#include "suggest.h"
+#include "output.h"
+#include "pool.h"
+
+#define SLOTS (2 * SUGGEST_MAX)         // pattern table of a guess, at most half full
+#define MIX 0x9E3779B97F4A7C15ULL       // odd multiplier hashing the pattern masks
+#define TIE 1e-9                        // scores closer than this are the same split
+
+/** @brief Sampled survivors and their scores, guesses are taken in order through next */
+typedef struct score_job {
+    const char **words;
+    uint8_t *hists;     // CHARSET letter counts for each word
+    double *score;      // entropy of each word as a guess
+    uint32_t m;
+    uint32_t next;
+    uint8_t wordsize;
+} score_job_t;
+
+static uint64_t pattern(score_job_t *, uint32_t, uint32_t, uint64_t *);
+static double entropy(score_job_t *, uint32_t, uint64_t *, uint32_t *);
+static void score_worker(void *, uint8_t);
+
+
+/**
+ * @brief Hashes the evaluation a guess would get against a ref
+ *
+ *  Same rules as eval_guess(): the matches take their letter out of the ref
+ *  histogram first, then the other positions take what's left from left to
+ *  right. Each word of the match mask is hashed with the mask of the '|' of
+ *  the same positions, everything else is a '/'.
+ *
+ * @param job       sampled survivors
+ * @param g         index of the guess
+ * @param r         index of the ref
+ * @param match     scratch for match_mask()
+ * @return uint64_t key of the pattern
+ */
+static uint64_t pattern(score_job_t *job, uint32_t g, uint32_t r, uint64_t *match){
+    const char *guess = job->words[g];
+    uint8_t left[CHARSET], index, has, w, k = job->wordsize;
+    uint64_t bits, present, key = 0;
+    uint8_t i;
+
+    match_mask(guess, job->words[r], k, match);
+    memcpy(left, job->hists + (size_t) r * CHARSET, sizeof(left));
+    for (w = 0; w <= (k >> 6); ++w){
+        for (bits = match[w]; bits != 0; bits &= bits - 1)
+            --(left[conversion_table[(int) guess[(w << 6) + __builtin_ctzll(bits)]]]);
+    }
+
+    for (w = 0; w <= (k >> 6); ++w){
+        bits = ~match[w];
+        if ((w << 6) + 64 > k) bits &= (1ULL << (k & 63)) - 1;
+        for (present = 0; bits != 0; bits &= bits - 1){
+            i = __builtin_ctzll(bits);
+            index = conversion_table[(int) guess[(w << 6) + i]];
+            has = left[index] != 0;
+            left[index] -= has;
+            present |= (uint64_t) has << i;
+        }
+
+        key = (key ^ match[w]) * MIX;
+        key = (key ^ present) * MIX;
+        key ^= key >> 32;
+    }
+
+    return key;
+}
+
+/**
+ * @brief Expected information gained by a guess, in bits
+ * @param job       sampled survivors
+ * @param g         index of the guess
+ * @param keys      SLOTS keys of the pattern table
+ * @param counts    SLOTS counts of the pattern table, 0 for an empty slot
+ * @return double   entropy of the split of the survivors
+ */
+static double entropy(score_job_t *job, uint32_t g, uint64_t *keys, uint32_t *counts){
+    uint64_t match[(job->wordsize >> 6) + 1], key;
+    uint32_t r, s;
+    double sum = 0;
+
+    memset(counts, 0, SLOTS * sizeof(uint32_t));
+    for (r = 0; r < job->m; ++r){
+        key = pattern(job, g, r, match);
+        for (s = key & (SLOTS - 1); counts[s] != 0 && keys[s] != key; s = (s + 1) & (SLOTS - 1));
+        keys[s] = key;
+        ++(counts[s]);
+    }
+
+    for (s = 0; s < SLOTS; ++s){
+        if (counts[s] > 1) sum += counts[s] * log2(counts[s]);
+    }
+    return log2(job->m) - sum / job->m;
+}
+
+/**
+ * @brief Scores guesses from the job until there are none left
+ * @param arg       score_job_t shared by the workers
+ * @param id        index of the thread in the pool
+ */
+static void score_worker(void *arg, uint8_t id){
+    score_job_t *job = (score_job_t *) arg;
+    uint64_t keys[SLOTS];
+    uint32_t counts[SLOTS], g;
+
+    (void) id;
+    while ((g = __atomic_fetch_add(&(job->next), 1, __ATOMIC_RELAXED)) < job->m){
+        job->score[g] = entropy(job, g, keys, counts);
+    }
+}
+
+/**
+ * @brief Prints the survivors that are the best next guesses
+ *
+ *  The sample takes every (n / SUGGEST_MAX)-th survivor, so it keeps their
+ *  order. Picked guesses are given a negative score, below any entropy. The
+ *  sums of two equal splits can differ in the last bits depending on the
+ *  order of the table, hence the tolerance on ties.
+ *
+ * @param rows      survivors in order, a line of wordsize + 1 chars each
+ * @param n         number of survivors
+ * @param wordsize  size of the words
+ * @param pooled    1 to score on the worker pool (pool.h), 0 on the calling thread
+ */
+void suggest(const char *rows, uint32_t n, uint8_t wordsize, uint8_t pooled){
+    uint32_t m = (n < SUGGEST_MAX) ? n : SUGGEST_MAX, j, t, best;
+    score_job_t job;
+    uint8_t c;
+
+    if (n == 0) return;
+    job.words = (const char **) malloc(m * sizeof(char *));
+    job.hists = (uint8_t *) calloc((size_t) m * CHARSET, sizeof(uint8_t));
+    job.score = (double *) malloc(m * sizeof(double));
+    if (job.words == NULL || job.hists == NULL || job.score == NULL) exit(EXIT_FAILURE);
+    job.m = m;
+    job.next = 0;
+    job.wordsize = wordsize;
+
+    for (j = 0; j < m; ++j){
+        job.words[j] = rows + (size_t)((uint64_t) j * n / m) * (wordsize + 1);
+        for (c = 0; c < wordsize; ++c) ++(job.hists[(size_t) j * CHARSET + conversion_table[(int) job.words[j][c]]]);
+    }
+
+    if (pooled) pool_run(score_worker, &job);
+    else score_worker(&job, 0);
+
+    for (t = 0; t < SUGGEST_TOP && t < m; ++t){
+        for (best = 0, j = 1; j < m; ++j){
+            if (job.score[j] > job.score[best] + TIE) best = j;
+        }
+        output_line(job.words[best], wordsize);
+        job.score[best] = -1;
+    }
+
+    free(job.words);
+    free(job.hists);
+    free(job.score);
+}
@@ -0,0 +1,42 @@
+/**
+ * @file suggest.h
+ * @author Andrea Sgobbi
+ * @date 17 October 2026
+ * @brief Header containing the next guess suggestions (+suggerisci)
+ *
+ *  A guess is worth as much as what its evaluation tells apart: if the ref
+ *  could be any of the survivors, the evaluation of a guess splits them into
+ *  classes, one for each pattern of '+', '|' and '/', and the expected
+ *  information gained is the entropy of that split
+ *
+ *      H(g) = log2(n) - sum over the classes of c/n * log2(c)
+ *
+ *  Every survivor is scored as a guess against every survivor as the ref, so
+ *  the cost is quadratic: above SUGGEST_MAX survivors both sides are an evenly
+ *  spread sample of them. Patterns aren't built as strings: the matches of a
+ *  pair come from match_mask() (16 positions per compare on x86-64), the '|'
+ *  from a copy of the histogram of the ref, and the two bitmasks are hashed
+ *  into a key. Keys are counted in a small open addressing table per guess.
+ *
+ *  Guesses are handed out to the threads of the pool one at a time, each
+ *  keeping its own table, and the best SUGGEST_TOP are printed in order, ties
+ *  going to the first in lexicographical order.
+ */
+#ifndef SUGGEST_H_
+#define SUGGEST_H_
+#include "game.h"
+
+#define SUGGEST_MAX 2048    // survivors scored, larger sets are sampled
+#define SUGGEST_TOP 5       // guesses printed
+
+
+/**
+ * @brief Prints the survivors that are the best next guesses     O(n^2 k)
+ * @param rows      survivors in order, a line of wordsize + 1 chars each
+ * @param n         number of survivors
+ * @param wordsize  size of the words
+ * @param pooled    1 to score on the worker pool (pool.h), 0 on the calling thread
+ */
+void suggest(const char *, uint32_t, uint8_t, uint8_t);
+
+#endif